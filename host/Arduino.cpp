@@ -0,0 +1,262 @@
+#include "Arduino.h"
+#include "EEPROM.h"
+#include "HostClock.h"
+
+HardwareSerial Serial;
+EEPROMClass EEPROM;
+
+// --- Clock ---
+static void (*millisecondHook)() = nullptr;
+
+// Microseconds since power on. Read the start on the first access: the constructors of the sketch
+// start timers before main() runs.
+static uint64_t& virtualClock() {
+  static uint64_t nowMicros = getenv("HOST_START_MILLIS") ? strtoull(getenv("HOST_START_MILLIS"), nullptr, 10) * 1000 : 0;
+  return nowMicros;
+}
+
+uint64_t hostTime() {
+  return virtualClock();
+}
+
+void hostAdvance(uint64_t micros) {
+  uint64_t& nowMicros = virtualClock();
+  uint64_t end = nowMicros + micros;
+  while (nowMicros < end) {
+    uint64_t nextMillisecond = (nowMicros / 1000 + 1) * 1000;
+    nowMicros = nextMillisecond < end ? nextMillisecond : end;
+    if (nowMicros % 1000 == 0 && millisecondHook) {
+      millisecondHook();
+    }
+  }
+}
+
+void hostSetMillisecondHook(void (*hook)()) {
+  millisecondHook = hook;
+}
+
+uint32_t millis() {
+  return (uint32_t)(virtualClock() / 1000);
+}
+
+uint32_t micros() {
+  return (uint32_t)virtualClock();
+}
+
+void delay(uint32_t ms) {
+  hostAdvance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  hostAdvance(us);
+}
+
+// the board sleeps until the next interrupt, the Timer0 tick
+void yield() {
+  hostAdvance(1000 - virtualClock() % 1000);
+}
+
+// --- Pins ---
+static uint8_t modes[HOST_PINS];
+static int inputs[HOST_PINS];
+static int outputs[HOST_PINS];
+static int analogValues[HOST_PINS];
+static bool pinsInitialized = false;
+static void (*pinWriteHook)(uint8_t pin, uint8_t level) = nullptr;
+
+static void initializePins() {
+  if (pinsInitialized) {
+    return;
+  }
+  for (uint8_t pin = 0; pin < HOST_PINS; pin++) {
+    inputs[pin] = -1;
+    outputs[pin] = -1;
+  }
+  pinsInitialized = true;
+}
+
+void hostSetInput(uint8_t pin, int level) {
+  initializePins();
+  if (pin < HOST_PINS) {
+    inputs[pin] = level;
+  }
+}
+
+void hostSetAnalog(uint8_t pin, int value) {
+  if (pin < HOST_PINS) {
+    analogValues[pin] = value;
+  }
+}
+
+int hostOutput(uint8_t pin) {
+  initializePins();
+  return pin < HOST_PINS ? outputs[pin] : -1;
+}
+
+void hostSetPinWriteHook(void (*hook)(uint8_t pin, uint8_t level)) {
+  pinWriteHook = hook;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin < HOST_PINS) {
+    modes[pin] = mode;
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+  initializePins();
+  if (pin >= HOST_PINS) {
+    return;
+  }
+  outputs[pin] = level ? HIGH : LOW;
+  if (pinWriteHook) {
+    pinWriteHook(pin, outputs[pin]);
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  initializePins();
+  if (pin >= HOST_PINS) {
+    return LOW;
+  }
+  if (modes[pin] == OUTPUT) {
+    return outputs[pin] == HIGH ? HIGH : LOW;
+  }
+  if (inputs[pin] >= 0) {
+    return inputs[pin];
+  }
+  return modes[pin] == INPUT_PULLUP ? HIGH : LOW;
+}
+
+int analogRead(uint8_t pin) {
+  return pin < HOST_PINS ? analogValues[pin] : 0;
+}
+
+void analogWrite(uint8_t pin, int value) {
+  digitalWrite(pin, value != 0);
+}
+
+// --- Random ---
+long random(long maxVal) {
+  return maxVal > 0 ? rand() % maxVal : 0;
+}
+
+long random(long minVal, long maxVal) {
+  return maxVal > minVal ? minVal + rand() % (maxVal - minVal) : minVal;
+}
+
+void randomSeed(unsigned long seed) {
+  srand(seed);
+}
+
+// --- Print ---
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t written = 0;
+  while (size--) {
+    written += write(*buffer++);
+  }
+  return written;
+}
+
+size_t Print::print(const char* text) {
+  return write((const uint8_t*)text, strlen(text));
+}
+
+size_t Print::print(char c) {
+  return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char value, int base) {
+  return print((unsigned long)value, base);
+}
+
+size_t Print::print(int value, int base) {
+  return print((long)value, base);
+}
+
+size_t Print::print(unsigned int value, int base) {
+  return print((unsigned long)value, base);
+}
+
+size_t Print::print(long value, int base) {
+  if (base == DEC && value < 0) {
+    return print('-') + print((unsigned long)-value, base);
+  }
+  return print((unsigned long)value, base);
+}
+
+size_t Print::print(unsigned long value, int base) {
+  char text[24];
+  snprintf(text, sizeof(text), base == HEX ? "%lX" : "%lu", value);
+  return print(text);
+}
+
+size_t Print::println() {
+  return print("\r\n");
+}
+
+// --- Serial ---
+static std::vector<uint8_t> serialInput;
+static size_t serialInputPosition = 0;
+static std::vector<uint8_t> serialOutput;
+
+void hostSerialInput(const uint8_t* data, size_t size) {
+  serialInput.insert(serialInput.end(), data, data + size);
+}
+
+std::vector<uint8_t>& hostSerialOutput() {
+  return serialOutput;
+}
+
+// like the 64 byte receive buffer of the board
+int HardwareSerial::available() {
+  size_t left = serialInput.size() - serialInputPosition;
+  return left > 63 ? 63 : (int)left;
+}
+
+int HardwareSerial::read() {
+  return serialInputPosition < serialInput.size() ? serialInput[serialInputPosition++] : -1;
+}
+
+int HardwareSerial::peek() {
+  return serialInputPosition < serialInput.size() ? serialInput[serialInputPosition] : -1;
+}
+
+size_t HardwareSerial::write(uint8_t value) {
+  serialOutput.push_back(value);
+  return 1;
+}
+
+// --- EEPROM ---
+static uint8_t eeprom[HOST_EEPROM_SIZE];
+static uint32_t eepromWrites = 0;
+
+void hostEraseEeprom() {
+  memset(eeprom, 0xFF, sizeof(eeprom));
+}
+
+// a new chip
+static struct EepromPowerOn {
+  EepromPowerOn() { hostEraseEeprom(); }
+} eepromPowerOn;
+
+uint32_t hostEepromWrites() {
+  return eepromWrites;
+}
+
+uint8_t EEPROMClass::read(int address) {
+  return address >= 0 && address < HOST_EEPROM_SIZE ? eeprom[address] : 0xFF;
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+  if (address >= 0 && address < HOST_EEPROM_SIZE) {
+    eeprom[address] = value;
+    eepromWrites++;
+  }
+}
+
+void EEPROMClass::update(int address, uint8_t value) {
+  if (read(address) != value) {
+    write(address, value);
+  }
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+// Arduino core emulation for the host build (see CMakeLists.txt and HostClock.h). It covers what the
+// sketch uses. Time is virtual: millis() and micros() only advance through delay(), yield() and
+// hostAdvance().
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// The ATmega328P has a 32 bit long, so millis() wraps around after 49.7 days and micros() after
+// 71.6 minutes. Here they return uint32_t, which is unsigned long on the board: the sketch keeps times
+// in uint32_t and compares them as int32_t, so it sees the same overflow on the host.
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define DEC 10
+#define HEX 16
+
+// --- Pins (Arduino Nano) ---
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+#define A6 20
+#define A7 21
+#define LED_BUILTIN 13
+#define HOST_PINS 22
+
+// --- Flash ---
+#define PROGMEM
+#define F(text) (text)
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+#define memcpy_P memcpy
+
+// --- Core ---
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+
+long random(long maxVal);
+long random(long minVal, long maxVal);
+void randomSeed(unsigned long seed);
+
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+// --- Print and Stream ---
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t value) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size);
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+
+  size_t print(const char* text);
+  size_t print(char c);
+  size_t print(unsigned char value, int base = DEC);
+  size_t print(int value, int base = DEC);
+  size_t print(unsigned int value, int base = DEC);
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+
+  size_t println();
+  template <typename T> size_t println(T value) { return print(value) + println(); }
+  template <typename T> size_t println(T value, int base) { return print(value, base) + println(); }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+};
+
+// The serial port of the board. Output and input are buffers of the host (see HostClock.h).
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long) {}
+  void end() {}
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t value) override;
+  using Print::write;
+  int availableForWrite() override { return 63; }  // the host takes the output at once
+  operator bool() { return true; }
+};
+
+extern HardwareSerial Serial;
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Arduino.h"
+
+// The part of Bounce2 the sketch uses: a level counts once it was stable for the interval.
+namespace Bounce2 {
+
+class Button {
+public:
+  void attach(int pin, int mode) {
+    this->pin = pin;
+    pinMode(pin, mode);
+    state = lastLevel = digitalRead(pin);
+    lastChange = millis();
+  }
+
+  void interval(uint16_t intervalMillis) { intervalMs = intervalMillis; }
+  void setPressedState(bool level) { pressedLevel = level; }
+
+  bool update() {
+    changed = false;
+    bool level = digitalRead(pin);
+    if (level != lastLevel) {
+      lastLevel = level;
+      lastChange = millis();
+    } else if (level != state && millis() - lastChange >= intervalMs) {
+      state = level;
+      changed = true;
+    }
+    return changed;
+  }
+
+  bool pressed() { return changed && state == pressedLevel; }
+  bool released() { return changed && state != pressedLevel; }
+  bool isPressed() { return state == pressedLevel; }
+
+private:
+  int pin = 0;
+  uint16_t intervalMs = 10;
+  bool pressedLevel = LOW;
+  bool state = HIGH;
+  bool lastLevel = HIGH;
+  bool changed = false;
+  uint32_t lastChange = 0;
+};
+
+}  // namespace Bounce2
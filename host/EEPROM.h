@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Arduino.h"
+
+#define HOST_EEPROM_SIZE 1024   // ATmega328P
+
+class EEPROMClass {
+public:
+  uint8_t read(int address);
+  void write(int address, uint8_t value);
+  void update(int address, uint8_t value);
+  uint16_t length() { return HOST_EEPROM_SIZE; }
+
+  template <typename T> T& get(int address, T& value) {
+    uint8_t* bytes = (uint8_t*)&value;
+    for (size_t i = 0; i < sizeof(T); i++) {
+      bytes[i] = read(address + i);
+    }
+    return value;
+  }
+
+  template <typename T> const T& put(int address, const T& value) {
+    const uint8_t* bytes = (const uint8_t*)&value;
+    for (size_t i = 0; i < sizeof(T); i++) {
+      update(address + i, bytes[i]);
+    }
+    return value;
+  }
+};
+
+extern EEPROMClass EEPROM;
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Arduino.h"
+
+// Control of the emulated board for host programs and tests: the virtual clock, the inputs the
+// sketch reads and the outputs it writes, the serial port and the EEPROM.
+
+// --- Clock ---
+// Virtual time in microseconds (64 bit, millis() and micros() wrap like on the board). It starts at
+// the environment variable HOST_START_MILLIS, or 0: e.g. shortly before the millis() wrap. Not settable
+// later, the constructors of the sketch already read millis() before main().
+uint64_t hostTime();
+
+// Advances the clock. hook runs at every millisecond boundary, like the Timer0 interrupts of the
+// board (sensor capture, shake samples). delay() and yield() advance the clock the same way.
+void hostAdvance(uint64_t micros);
+void hostSetMillisecondHook(void (*hook)());
+
+// --- Pins ---
+// Level an input reads. Inputs never set read the pull-up (INPUT_PULLUP) or LOW.
+void hostSetInput(uint8_t pin, int level);
+void hostSetAnalog(uint8_t pin, int value);
+
+// Last level written to an output, -1 if never written
+int hostOutput(uint8_t pin);
+
+// Called on every digitalWrite() and analogWrite() (value != 0 is HIGH)
+void hostSetPinWriteHook(void (*hook)(uint8_t pin, uint8_t level));
+
+// --- Serial ---
+void hostSerialInput(const uint8_t* data, size_t size);
+std::vector<uint8_t>& hostSerialOutput();
+
+// --- EEPROM ---
+void hostEraseEeprom();                  // all bytes 0xFF, like a new chip
+uint32_t hostEepromWrites();             // bytes written since power on (write() always, update() if changed)
@@ -0,0 +1,85 @@
+#include "Simulation.h"
+#include "SensorCapture.h"
+#include "ShakeDetector.h"
+
+// globals of script.ino
+void setup();
+void loop();
+extern ShakeDetector shakeDetector;
+extern DFPlayerEmulator DFPlayerSoftwareSerial;
+
+static const uint8_t buttonPins[3] = { 12, A3, A5 };
+static const uint16_t SHAKE_REST_LEVEL = 512;
+static uint16_t shakeAmplitude = 0;
+static uint32_t noise = 1;
+
+// own generator, so the shake noise does not change the random numbers of the sketch
+static uint16_t nextNoise() {
+  noise ^= noise << 13;
+  noise ^= noise >> 17;
+  noise ^= noise << 5;
+  return (uint16_t)noise;
+}
+
+// the Timer0 interrupt of the board
+static void everyMillisecond() {
+  captureSensors();
+  uint16_t sample = SHAKE_REST_LEVEL + (nextNoise() & 1);
+  if (shakeAmplitude) {
+    sample = SHAKE_REST_LEVEL - shakeAmplitude + nextNoise() % (2 * shakeAmplitude + 1);
+  }
+  shakeDetector.addSample(sample);
+}
+
+void beginSimulation() {
+  hostEraseEeprom();
+  setHand(false);
+  setRoom(false);
+  setShaking(0);
+  for (uint8_t button = 1; button <= 3; button++) {
+    setButton(button, false);
+  }
+  hostSetAnalog(SIM_SHAKE_PIN, SHAKE_REST_LEVEL);
+  setup();
+  hostSetMillisecondHook(everyMillisecond);
+}
+
+void rebootSimulation() {
+  setup();
+}
+
+void runSimulation(uint64_t ms, void (*afterLoop)()) {
+  uint64_t end = hostTime() + ms * 1000;
+  while (hostTime() < end) {
+    loop();
+    if (afterLoop) {
+      afterLoop();
+    }
+  }
+}
+
+void setHand(bool present) {
+  hostSetInput(SIM_HAND_PIN, present ? LOW : HIGH);
+}
+
+void setRoom(bool present) {
+  hostSetInput(SIM_ROOM_PIN, present ? HIGH : LOW);
+}
+
+void setShaking(uint16_t amplitude) {
+  shakeAmplitude = amplitude < SHAKE_REST_LEVEL ? amplitude : SHAKE_REST_LEVEL - 1;
+}
+
+void setButton(uint8_t button, bool pressed) {
+  if (button >= 1 && button <= 3) {
+    hostSetInput(buttonPins[button - 1], pressed ? LOW : HIGH);
+  }
+}
+
+DFPlayerEmulator& simulatedPlayer() {
+  return DFPlayerSoftwareSerial;
+}
+
+bool pumpOn() {
+  return hostOutput(SIM_PUMP_PIN) == LOW;
+}
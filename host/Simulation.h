@@ -0,0 +1,47 @@
+#pragma once
+
+#include "HostClock.h"
+#include "DFPlayerEmulator.h"
+
+// Runs script.ino on the virtual clock. The host program sets the sensors, the simulation calls
+// setup() and loop() and takes the parts of the board the sketch expects: the Timer0 sensor capture
+// and the shake sensor samples at every millisecond.
+
+// Pins of script.ino
+#define SIM_HAND_PIN A0                // active low
+#define SIM_ROOM_PIN A1                // active high
+#define SIM_SHAKE_PIN A2
+#define SIM_PUMP_PIN 7                 // outputs are active low
+#define SIM_BIRD_FLAP_PIN 6
+#define SIM_BIRD_MOTOR1_VCC_PIN 2      // bird moves out
+#define SIM_BIRD_MOTOR2_VCC_PIN 4      // bird moves in
+
+// Folders of the SD card (see script.ino)
+#define SIM_FOLDER_BIRD 1
+#define SIM_FOLDER_SHAKE 2
+#define SIM_FOLDER_BEEP 3
+#define SIM_FOLDER_ROOM_START 4
+
+#define SIM_VOLUME 23                  // VOLUME of script.ino
+
+// A new EEPROM, all sensors idle, then setup(). The clock starts at HOST_START_MILLIS (see HostClock.h).
+void beginSimulation();
+
+// A warm boot: setup() again with the EEPROM kept. The other globals of the sketch keep their values,
+// so reboot only an idle unit.
+void rebootSimulation();
+
+// Runs loop() for ms milliseconds. afterLoop, if set, runs after every loop(), e.g. for checks.
+void runSimulation(uint64_t ms, void (*afterLoop)() = nullptr);
+
+// Sensors
+void setHand(bool present);
+void setRoom(bool present);
+void setShaking(uint16_t amplitude);   // random samples around the resting level, 0: at rest
+void setButton(uint8_t button, bool pressed);  // button 1-3
+
+// The emulated DFPlayer of the sketch
+DFPlayerEmulator& simulatedPlayer();
+
+// Outputs are active low
+bool pumpOn();
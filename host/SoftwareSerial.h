@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Arduino.h"
+
+// Nothing is connected on the host: writes are dropped and nothing is received.
+// The host build uses DFPLAYER_EMULATOR instead.
+class SoftwareSerial : public Stream {
+public:
+  SoftwareSerial(uint8_t, uint8_t) {}
+  void begin(long) {}
+  void end() {}
+  bool listen() { return true; }
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  size_t write(uint8_t) override { return 1; }
+  using Print::write;
+};
@@ -0,0 +1,64 @@
+// Runs the sketch for some simulated days with random visitors and prints what the unit did.
+//   kookoo_sim [days] [seed]
+// HOST_START_MILLIS=4290000000 kookoo_sim runs through the millis() wrap.
+
+#include "Simulation.h"
+
+static uint32_t pumpRuns = 0;
+static uint32_t birdMoves = 0;
+static uint32_t soundsStarted = 0;
+static uint8_t lastFolder = 0;
+
+static void countOutputs(uint8_t pin, uint8_t level) {
+  if (level != LOW) {
+    return;
+  }
+  if (pin == SIM_PUMP_PIN) {
+    pumpRuns++;
+  } else if (pin == SIM_BIRD_MOTOR1_VCC_PIN) {
+    birdMoves++;
+  }
+}
+
+static void countSounds() {
+  DFPlayerEmulator& player = simulatedPlayer();
+  uint8_t folder = player.isPlaying() ? player.playingFolder() : 0;
+  if (folder && folder != lastFolder) {
+    soundsStarted++;
+  }
+  lastFolder = folder;
+}
+
+int main(int argc, char** argv) {
+  uint32_t days = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1;
+  srand(argc > 2 ? strtoul(argv[2], nullptr, 10) : 1);
+  uint64_t start = hostTime() / 1000;
+
+  beginSimulation();
+  hostSetPinWriteHook(countOutputs);
+  uint32_t visitors = 0;
+  for (uint32_t minute = 0; minute < days * 24 * 60; minute++) {
+    if (rand() % 10 == 0) {
+      visitors++;
+      setRoom(true);
+      runSimulation(2000 + rand() % 5000, countSounds);
+      setHand(true);
+      runSimulation(200 + rand() % 800, countSounds);
+      setHand(false);
+      if (rand() % 50 == 0) {
+        setShaking(150);
+        runSimulation(1500, countSounds);
+        setShaking(0);
+      }
+      runSimulation(10000 + rand() % 20000, countSounds);
+      setRoom(false);
+    }
+    runSimulation(60000 - hostTime() / 1000 % 60000, countSounds);
+  }
+
+  printf("%u days from %.0f ms: %u visitors, %u pump runs, %u bird moves, %u sounds\n", (unsigned)days,
+         (double)start, (unsigned)visitors, (unsigned)pumpRuns, (unsigned)birdMoves, (unsigned)soundsStarted);
+  printf("%u DFPlayer frames rejected, %u EEPROM writes\n", (unsigned)simulatedPlayer().framesRejected(),
+         (unsigned)hostEepromWrites());
+  return 0;
+}
@@ -0,0 +1,2 @@
+// script.ino as a C++ translation unit for the host build. The sketch itself stays unchanged.
+#include "script.ino"
@@ -1,8 +1,8 @@
 #include "BirdFlapGenerator.h"
+#include "FlapTables.h"
 
 // --- Constants ---
 const uint16_t TOTAL_DURATION_MS = 7000;
-const int MAX_FLAPS = 70; //never above 254
 
 const uint16_t FLAP_MIN = 50;
 const uint16_t FLAP_MAX = 170;
@@ -12,52 +12,76 @@ const uint16_t BREAK_MAX = 200;
 const uint16_t PAUSE_BREAK_MIN = 400;
 const uint16_t PAUSE_BREAK_MAX = 650;
 
-const int BURST_MIN_FLAPS = 2;
-const int BURST_MAX_FLAPS = 5;
+const uint8_t BURST_MIN_FLAPS = 2;
+const uint8_t BURST_MAX_FLAPS = 4;   // inclusive like all bounds of randomBetween(): bursts of 2-4 flaps
 
-// --- Buffers ---
-static uint16_t flapBuffer[MAX_FLAPS];
-static uint16_t breakBuffer[MAX_FLAPS+1];
+const uint16_t TABLE_DURATION_TOLERANCE = 300;  // the learned duration includes the start delay of the DFPlayer
 
-// --- Internal Utility ---
-static uint16_t randomBetween(uint16_t minVal, uint16_t maxVal) {
-  return random(minVal, maxVal + 1);
+// --- Speech-Like Generator ---
+void SpeechFlapGenerator::begin(uint16_t totalDurationMs, uint16_t seed) {
+  randomState = seed ? seed : 1;  // xorshift never leaves 0
+  timeLeft = totalDurationMs ? totalDurationMs : TOTAL_DURATION_MS;
+  pendingBreak = 0;
+  flapsLeftInBurst = randomBetween(BURST_MIN_FLAPS, BURST_MAX_FLAPS);
 }
 
-// --- Generator Implementation ---
-void generateSpeechLikeFlappingPattern(SoundParams& params) {
-  uint16_t timeSoFar = 0;
-  int index = 0;
-
-  while (timeSoFar < TOTAL_DURATION_MS && index + 6 < MAX_FLAPS) {
-    Serial.print("timeSoFar ");
-    Serial.println(timeSoFar);
-    Serial.print("index ");
-    Serial.println(index);
-    int flapsInBurst = random(BURST_MIN_FLAPS, BURST_MAX_FLAPS);
-
-    for (int j = 0; j < flapsInBurst && timeSoFar < TOTAL_DURATION_MS; j++) {
-      uint16_t flapTime = randomBetween(FLAP_MIN, FLAP_MAX);
-      uint16_t breakTime = randomBetween(BREAK_MIN, BREAK_MAX);
-
-      flapBuffer[index] = flapTime;
-      breakBuffer[index] = breakTime;
-      timeSoFar += flapTime + breakTime;
-      index++;
-    }
+// 16 bit xorshift (7, 9, 8): period 65535, a few instructions on the AVR
+uint16_t SpeechFlapGenerator::randomBetween(uint16_t minVal, uint16_t maxVal) {
+  randomState ^= randomState << 7;
+  randomState ^= randomState >> 9;
+  randomState ^= randomState << 8;
+  return minVal + (uint16_t)(((uint32_t)randomState * (maxVal - minVal + 1)) >> 16);  // no division
+}
+
+uint16_t SpeechFlapGenerator::nextFlap() {
+  if (timeLeft == 0) {
+    return 0;
+  }
+  uint16_t flapTime = randomBetween(FLAP_MIN, FLAP_MAX);
 
-    // Add longer pause (like a speech pause)
-    if (timeSoFar + PAUSE_BREAK_MIN < TOTAL_DURATION_MS && index < MAX_FLAPS) {
-      flapBuffer[index] = randomBetween(FLAP_MIN, FLAP_MAX);
-      breakBuffer[index] = randomBetween(PAUSE_BREAK_MIN, PAUSE_BREAK_MAX);
-      timeSoFar += breakBuffer[index];
-      index++;
+  if (flapsLeftInBurst == 0 && timeLeft > PAUSE_BREAK_MIN) {
+    // end of a burst: a longer pause (like a speech pause), then the next burst
+    pendingBreak = randomBetween(PAUSE_BREAK_MIN, PAUSE_BREAK_MAX);
+    flapsLeftInBurst = randomBetween(BURST_MIN_FLAPS, BURST_MAX_FLAPS);
+  } else {
+    pendingBreak = randomBetween(BREAK_MIN, BREAK_MAX);
+    if (flapsLeftInBurst > 0) {
+      flapsLeftInBurst--;
     }
   }
 
-  // Assign generated data to the struct
-  params.flapPattern = flapBuffer;
-  params.flapBreakPattern = breakBuffer;
-  params.flapPatternSize = index;
-  params.flapBreakPatternSize = index;
-}
\ No newline at end of file
+  uint16_t used = flapTime + pendingBreak;
+  timeLeft = timeLeft > used ? timeLeft - used : 0;
+  return flapTime;
+}
+
+uint16_t SpeechFlapGenerator::nextBreak() {
+  uint16_t breakTime = pendingBreak;
+  pendingBreak = 0;
+  return breakTime;
+}
+
+// --- Lip Sync Tables ---
+bool selectFlapTable(SoundParams& params, uint8_t folder, uint8_t file, uint16_t learnedDuration) {
+  params.flapTicks = nullptr;
+  params.flapBreakTicks = nullptr;
+  params.flapGenerator = nullptr;
+
+  for (uint8_t i = 0; i < sizeof(flapTables) / sizeof(flapTables[0]); i++) {
+    FlapTable table;
+    memcpy_P(&table, &flapTables[i], sizeof(table));
+    if (table.folder != folder || table.file != file) {
+      continue;
+    }
+    if (learnedDuration != 0 && abs((int32_t)learnedDuration - (int32_t)table.duration) > table.duration / 8 + TABLE_DURATION_TOLERANCE) {
+      return false;
+    }
+
+    params.flapTicks = table.flaps;
+    params.flapBreakTicks = table.breaks;
+    params.flapPatternSize = table.flapCount;
+    params.flapBreakPatternSize = table.breakCount;
+    return true;
+  }
+  return false;
+}
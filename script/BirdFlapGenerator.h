@@ -2,14 +2,56 @@
 
 #include "Arduino.h"
 
+const uint8_t FLAP_TICK_MS = 10;   // unit of the lip sync tables
+
+// Speech-like flapping: bursts of 2-4 quick flaps, separated by longer pauses, for a given time.
+// The durations are made on demand, one flap (and the break after it) at a time, from a few bytes
+// of state. The same seed gives the same pattern.
+class SpeechFlapGenerator {
+public:
+  // Starts a new pattern of totalDurationMs (0: default length of 7s)
+  void begin(uint16_t totalDurationMs, uint16_t seed);
+
+  bool hasFlap() const { return timeLeft > 0; }
+  bool hasBreak() const { return pendingBreak > 0; }
+
+  // Duration of the next flap, and of the break after it
+  uint16_t nextFlap();
+  uint16_t nextBreak();
+
+private:
+  uint16_t randomState = 1;
+  uint16_t timeLeft = 0;
+  uint16_t pendingBreak = 0;
+  uint8_t flapsLeftInBurst = 0;
+
+  uint16_t randomBetween(uint16_t minVal, uint16_t maxVal);
+};
+
 struct SoundParams {
   uint8_t folderId;
   bool triggerBird;
-  uint16_t* flapBreakPattern;  // Pointer to an array of uint16_t
-  uint16_t* flapPattern;       // Pointer to an array of uint16_t
+  bool speechLikeFlapping;     // generate the flap pattern when the file (and its duration) is known
+  const uint16_t* flapBreakPattern;  // Pointer to an array of uint16_t
+  const uint16_t* flapPattern;       // Pointer to an array of uint16_t
+  const uint8_t* flapBreakTicks;     // lip sync table in PROGMEM (FLAP_TICK_MS), used instead of the patterns when set
+  const uint8_t* flapTicks;
+  SpeechFlapGenerator* flapGenerator;  // replaces patterns and tables when set
   uint8_t flapBreakPatternSize;    // Size of the flapBreakPattern array
   uint8_t flapPatternSize;         // Size of the flapPattern array
 };
 
-// Call this to generate 15s of speech-like flapping
-void generateSpeechLikeFlappingPattern(SoundParams& params);
\ No newline at end of file
+// Flaps and breaks that follow the speech of one sound file, generated by tools/flapTables.py
+struct FlapTable {
+  uint8_t folder;
+  uint8_t file;
+  uint16_t duration;           // ms
+  const uint8_t* flaps;        // PROGMEM, FLAP_TICK_MS
+  const uint8_t* breaks;
+  uint8_t flapCount;
+  uint8_t breakCount;
+};
+
+// Selects the lip sync table of the file (FlapTables.h). Returns false if there is none, or if the
+// learned duration (0: unknown) shows that the card has another sound under that number
+bool selectFlapTable(SoundParams& params, uint8_t folder, uint8_t file, uint16_t learnedDuration);
\ No newline at end of file
@@ -0,0 +1,182 @@
+#include "Choreography.h"
+
+// --- Constants ---
+const uint8_t MAX_STEPS_PER_UPDATE = 16;  // protects against tables looping without any duration
+
+// --- State ---
+static const ChoreoStep* table = nullptr;
+static uint8_t cursor = CHOREO_END;
+static uint32_t stepDue = 0;
+static uint16_t maxLateness = 0;
+static bool finishing = false;
+static bool patternWait = false;          // the current step waits for a flap or break of the pattern
+static void (*pinTap)(uint8_t pin, uint8_t level) = nullptr;
+
+// start requested while a choreography ran, it begins after the end steps of the running one
+static const ChoreoStep* pendingTable = nullptr;
+static SoundParams pendingParams;
+
+static const uint16_t* flapPattern;
+static const uint16_t* breakPattern;
+static const uint8_t* flapTicks;          // PROGMEM lip sync table, replaces the patterns when set
+static const uint8_t* breakTicks;
+static SpeechFlapGenerator* generator;    // replaces patterns and tables when set
+static uint8_t flapCount;
+static uint8_t breakCount;
+static uint8_t flapIndex;
+static uint8_t breakIndex;
+
+// --- Internal Utility ---
+static bool conditionHolds(uint8_t condition) {
+  if (generator) {
+    // generated patterns start with a flap
+    switch (condition) {
+      case CHOREO_IF_BREAK_FIRST:
+        return false;
+      case CHOREO_IF_FLAP_LEFT:
+        return !finishing && generator->hasFlap();
+      case CHOREO_IF_BREAK_LEFT:
+        return !finishing && generator->hasBreak();
+      default:
+        return true;
+    }
+  }
+
+  switch (condition) {
+    case CHOREO_IF_BREAK_FIRST:
+      return breakCount - breakIndex > flapCount - flapIndex;
+    case CHOREO_IF_FLAP_LEFT:
+      return !finishing && flapIndex < flapCount;
+    case CHOREO_IF_BREAK_LEFT:
+      return !finishing && breakIndex < breakCount;
+    default:
+      return true;
+  }
+}
+
+static uint16_t stepDuration(uint16_t duration) {
+  if (generator && duration == CHOREO_FLAP_TIME) {
+    return generator->nextFlap();
+  }
+  if (generator && duration == CHOREO_BREAK_TIME) {
+    return generator->nextBreak();
+  }
+  if (duration == CHOREO_FLAP_TIME) {
+    if (flapIndex >= flapCount) {
+      return 0;
+    }
+    uint8_t i = flapIndex++;
+    return flapTicks ? pgm_read_byte(&flapTicks[i]) * FLAP_TICK_MS : flapPattern[i];
+  }
+  if (duration == CHOREO_BREAK_TIME) {
+    if (breakIndex >= breakCount) {
+      return 0;
+    }
+    uint8_t i = breakIndex++;
+    return breakTicks ? pgm_read_byte(&breakTicks[i]) * FLAP_TICK_MS : breakPattern[i];
+  }
+  return duration;
+}
+
+static void beginTable(const ChoreoStep* steps, const SoundParams& params, uint32_t now) {
+  table = steps;
+  flapPattern = params.flapPattern;
+  breakPattern = params.flapBreakPattern;
+  flapTicks = params.flapTicks;
+  breakTicks = params.flapBreakTicks;
+  generator = params.flapGenerator;
+  flapCount = params.flapPatternSize;
+  breakCount = params.flapBreakPatternSize;
+  flapIndex = 0;
+  breakIndex = 0;
+  finishing = false;
+  patternWait = false;
+
+  cursor = 0;
+  stepDue = now;
+}
+
+// --- Implementation ---
+void startChoreography(const ChoreoStep* steps, const SoundParams& params) {
+  if (cursor != CHOREO_END) {
+    // the pins of the running table are only safe after its end steps (bird in): cut it short and queue
+    finishChoreography();
+    pendingTable = steps;
+    pendingParams = params;
+    return;
+  }
+  beginTable(steps, params, millis());
+  updateChoreography();
+}
+
+void finishChoreography() {
+  finishing = true;
+  pendingTable = nullptr;  // its sound is over as well
+
+  // a flap or break in progress ends now. Fixed durations (bird out) keep their time
+  uint32_t now = millis();
+  if (patternWait && (int32_t)(now - stepDue) < 0) {
+    stepDue = now;
+  }
+}
+
+void updateChoreography() {
+  uint32_t now = millis();
+
+  for (uint8_t i = 0; i < MAX_STEPS_PER_UPDATE; i++) {
+    if (cursor == CHOREO_END && pendingTable) {
+      beginTable(pendingTable, pendingParams, now);
+      pendingTable = nullptr;
+    }
+    if (cursor == CHOREO_END || (int32_t)(now - stepDue) < 0) {
+      return;
+    }
+
+    ChoreoStep step;
+    memcpy_P(&step, &table[cursor], sizeof(step));
+
+    if (!conditionHolds(step.condition)) {
+      cursor = step.elseStep;
+      continue;
+    }
+
+    uint16_t late = now - stepDue;
+    if (late > maxLateness) {
+      maxLateness = late;
+    }
+
+    if (step.pin != CHOREO_NO_PIN) {
+      digitalWrite(step.pin, step.level);
+      if (pinTap) {
+        pinTap(step.pin, step.level);
+      }
+    }
+    stepDue += stepDuration(step.duration);
+    patternWait = step.duration == CHOREO_FLAP_TIME || step.duration == CHOREO_BREAK_TIME;
+    cursor = step.next;
+  }
+}
+
+bool isChoreographyActive() {
+  return cursor != CHOREO_END || pendingTable;
+}
+
+bool choreographyNextDeadline(uint32_t& when) {
+  if (cursor == CHOREO_END) {
+    return false;
+  }
+  when = stepDue;
+  return true;
+}
+
+uint16_t choreographyMaxLateness() {
+  return maxLateness;
+}
+
+void resetChoreographyMaxLateness() {
+  maxLateness = 0;
+}
+
+void setChoreographyPinTap(void (*tap)(uint8_t pin, uint8_t level)) {
+  pinTap = tap;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Arduino.h"
+#include "BirdFlapGenerator.h"
+
+// A choreography is a table of steps in PROGMEM, run by one cursor from loop().
+// Each step sets one pin, holds for its duration and then continues with step "next".
+// A step with a condition is skipped (continue with "elseStep") while the condition is false.
+// Step times are planned from the previous planned time, so delays of the loop do not add up.
+
+// --- Step Table ---
+const uint8_t CHOREO_NO_PIN = 0xFF;        // step only waits
+const uint8_t CHOREO_END = 0xFF;           // as next/elseStep: the choreography is done
+
+const uint16_t CHOREO_FLAP_TIME = 0xFFFF;  // duration: next value of the flap pattern
+const uint16_t CHOREO_BREAK_TIME = 0xFFFE; // duration: next value of the flap break pattern
+
+enum ChoreoCondition : uint8_t {
+  CHOREO_ALWAYS,
+  CHOREO_IF_BREAK_FIRST,   // the pattern has more breaks than flaps, so it starts with a break
+  CHOREO_IF_FLAP_LEFT,     // flaps left and not finishing
+  CHOREO_IF_BREAK_LEFT     // breaks left and not finishing
+};
+
+struct ChoreoStep {
+  uint8_t pin;
+  uint8_t level;
+  uint16_t duration;       // ms, CHOREO_FLAP_TIME or CHOREO_BREAK_TIME
+  uint8_t condition;
+  uint8_t elseStep;
+  uint8_t next;
+};
+
+// --- Engine ---
+// Starts the table at step 0 with the flap patterns of params. A running choreography is finished
+// first (see finishChoreography()), the new one starts after its end steps.
+void startChoreography(const ChoreoStep* steps, const SoundParams& params);
+
+// Makes the flap conditions false and ends a flap or break in progress, so the choreography goes to
+// its end steps (bird in). Drops a queued start.
+void finishChoreography();
+
+// Call this in loop(): runs all steps that are due
+void updateChoreography();
+
+bool isChoreographyActive();
+
+// Planned time of the next step. Returns false if no choreography runs.
+bool choreographyNextDeadline(uint32_t& when);
+
+// Largest delay (ms) of a step against its planned time since the last reset, over all choreographies
+uint16_t choreographyMaxLateness();
+void resetChoreographyMaxLateness();
+
+// Additionally hands every pin change of a step to tap, e.g. to put the bird on the timeline
+void setChoreographyPinTap(void (*tap)(uint8_t pin, uint8_t level));
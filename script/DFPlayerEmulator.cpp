@@ -0,0 +1,348 @@
+/*!
+ * @file DFPlayerEmulator.cpp
+ * @brief Implementation of the DFPlayer Mini emulator declared in DFPlayerEmulator.h.
+ */
+
+#include "DFPlayerEmulator.h"
+
+// Values as reported by the module (see DFRobotDFPlayerMini.h)
+#define EMULATOR_ERROR_BUSY 1           // also: no card
+#define EMULATOR_ERROR_WRONG_STACK 3
+#define EMULATOR_ERROR_CHECKSUM 4
+#define EMULATOR_ERROR_FILE_MISMATCH 6
+#define EMULATOR_DEVICE_SD 0x02
+
+DFPlayerEmulator::DFPlayerEmulator() :
+    _commandIndex(0), _outIndex(10), _nextByteTime(0), _rxHead(0), _rxCount(0),
+    _powered(false), _cardPresent(true), _online(false), _onlineAt(0),
+    _volume(30), _eq(0), _playFolder(0), _playFile(0), _paused(false), _playStart(0), _pausedAt(0),
+    _ackDelay(15), _responseDelay(30), _resetDuration(1500), _byteTime(1),
+    _dropBytes(0), _badChecksums(0), _duplicateFrames(0), _reorderReplies(0),
+    _framesReceived(0), _framesRejected(0), _framesSent(0), _bytesLost(0) {
+    for (uint8_t i = 0; i < DFPLAYER_EMULATOR_FRAMES; ++i) {
+        _frameUsed[i] = false;
+    }
+    for (uint8_t i = 0; i < DFPLAYER_EMULATOR_FOLDERS; ++i) {
+        _fileCount[i] = 0;
+        _duration[i] = 0;
+    }
+}
+
+// Power up: the module resets itself and reports "online" after the reset duration
+void DFPlayerEmulator::begin(long speed) {
+    (void)speed;  // the emulator has no baud rate, see setByteTime()
+    _powered = true;
+    _commandIndex = 0;
+    reset();
+}
+
+void DFPlayerEmulator::end() {
+    _powered = false;
+    _commandIndex = 0;
+    _outIndex = 10;
+    _rxCount = 0;
+    for (uint8_t i = 0; i < DFPLAYER_EMULATOR_FRAMES; ++i) {
+        _frameUsed[i] = false;
+    }
+}
+
+int DFPlayerEmulator::available() {
+    update();
+    return _rxCount;
+}
+
+int DFPlayerEmulator::read() {
+    update();
+    if (_rxCount == 0) {
+        return -1;
+    }
+    uint8_t byteOut = _rx[_rxHead];
+    _rxHead = (_rxHead + 1) % DFPLAYER_EMULATOR_RX_SIZE;
+    _rxCount--;
+    return byteOut;
+}
+
+int DFPlayerEmulator::peek() {
+    update();
+    return (_rxCount == 0) ? -1 : _rx[_rxHead];
+}
+
+// Bytes from the driver. A complete frame is checked and executed like the module would.
+size_t DFPlayerEmulator::write(uint8_t byteIn) {
+    update();
+    if (!_powered) {
+        return 1;
+    }
+    if (_commandIndex == 0 && byteIn != 0x7E) {
+        return 1;  // waiting for the start byte
+    }
+    _command[_commandIndex++] = byteIn;
+    if (_commandIndex < 10) {
+        return 1;
+    }
+    _commandIndex = 0;
+    _framesReceived++;
+
+    uint16_t sum = 0;
+    for (uint8_t i = 1; i <= 6; ++i) {
+        sum += _command[i];
+    }
+    uint16_t checkSum = ((uint16_t)_command[7] << 8) | _command[8];
+    if (_command[1] != 0xFF || _command[2] != 0x06 || _command[9] != 0xEF) {
+        _framesRejected++;
+        reply(0x40, EMULATOR_ERROR_WRONG_STACK, _ackDelay);
+    } else if ((uint16_t)(0 - sum) != checkSum) {
+        _framesRejected++;
+        reply(0x40, EMULATOR_ERROR_CHECKSUM, _ackDelay);
+    } else {
+        executeCommand();
+    }
+    return 1;
+}
+
+void DFPlayerEmulator::setFolder(uint8_t folder, uint8_t fileCount, uint16_t durationMs) {
+    if (folder == 0 || folder >= DFPLAYER_EMULATOR_FOLDERS) {
+        return;
+    }
+    _fileCount[folder] = fileCount;
+    _duration[folder] = durationMs;
+}
+
+void DFPlayerEmulator::insertCard() {
+    _cardPresent = true;
+    reply(0x3A, EMULATOR_DEVICE_SD, 0);
+    reply(0x3F, EMULATOR_DEVICE_SD, _resetDuration);
+}
+
+void DFPlayerEmulator::removeCard() {
+    stopPlayback();
+    _cardPresent = false;
+    reply(0x3B, EMULATOR_DEVICE_SD, 0);
+}
+
+bool DFPlayerEmulator::isPlaying() {
+    update();
+    return _playFolder != 0 && !_paused;
+}
+
+uint16_t DFPlayerEmulator::fileDuration(uint8_t folder, uint8_t file) {
+    (void)file;
+    return _duration[folder];
+}
+
+// Advance the module: end of reset, end of the playing clip and the transfer of due frames
+void DFPlayerEmulator::update() {
+    uint32_t now = millis();
+
+    if (!_online && _powered && (int32_t)(now - _onlineAt) >= 0) {
+        _online = true;
+    }
+
+    if (_playFolder != 0 && !_paused && now - _playStart >= fileDuration(_playFolder, _playFile)) {
+        // Play finished reports the global track number
+        uint16_t track = _playFile;
+        for (uint8_t i = 1; i < _playFolder; ++i) {
+            track += _fileCount[i];
+        }
+        stopPlayback();
+        reply(0x3D, track, 0);
+    }
+
+    while (true) {
+        if (_outIndex >= 10) {
+            // Nothing in transfer: take the frame with the earliest due time
+            int8_t next = -1;
+            for (uint8_t i = 0; i < DFPLAYER_EMULATOR_FRAMES; ++i) {
+                if (_frameUsed[i] && (int32_t)(now - _frameDue[i]) >= 0 &&
+                    (next < 0 || (int32_t)(_frameDue[i] - _frameDue[next]) < 0)) {
+                    next = i;
+                }
+            }
+            if (next < 0) {
+                return;
+            }
+            uint16_t sum = 0xFF + 0x06 + _frameCommand[next] + (_frameParameter[next] >> 8) + (_frameParameter[next] & 0xFF);
+            uint16_t checkSum = 0 - sum;
+            if (chance(_badChecksums)) {
+                checkSum ^= 0x0101;
+            }
+            _outFrame[0] = 0x7E;
+            _outFrame[1] = 0xFF;
+            _outFrame[2] = 0x06;
+            _outFrame[3] = _frameCommand[next];
+            _outFrame[4] = 0x00;
+            _outFrame[5] = (uint8_t)(_frameParameter[next] >> 8);
+            _outFrame[6] = (uint8_t)(_frameParameter[next] & 0xFF);
+            _outFrame[7] = (uint8_t)(checkSum >> 8);
+            _outFrame[8] = (uint8_t)(checkSum & 0xFF);
+            _outFrame[9] = 0xEF;
+            if (chance(_duplicateFrames)) {
+                _frameDue[next] = now;  // keep the slot, it is sent once more right after this one
+            } else {
+                _frameUsed[next] = false;
+            }
+            _framesSent++;
+            _outIndex = 0;
+            _nextByteTime = now;
+        }
+        while (_outIndex < 10 && (int32_t)(now - _nextByteTime) >= 0) {
+            uint8_t byteOut = _outFrame[_outIndex++];
+            if (chance(_dropBytes)) {
+                _bytesLost++;
+            } else {
+                pushByte(byteOut);
+            }
+            _nextByteTime += _byteTime;
+        }
+        if (_outIndex < 10) {
+            return;  // rest of the frame is still on the line
+        }
+    }
+}
+
+void DFPlayerEmulator::executeCommand() {
+    uint8_t command = _command[3];
+    bool ackRequested = (_command[4] == 0x01);
+    uint16_t parameter = ((uint16_t)_command[5] << 8) | _command[6];
+
+    if (!_online) {
+        return;  // still initializing, the module does not react
+    }
+    if (ackRequested) {
+        reply(0x41, 0, _ackDelay);
+    }
+
+    switch (command) {
+        case 0x03: { // play by global track number
+            uint8_t folder = 1;
+            while (folder < DFPLAYER_EMULATOR_FOLDERS && parameter > _fileCount[folder]) {
+                parameter -= _fileCount[folder];
+                folder++;
+            }
+            _command[5] = (folder < DFPLAYER_EMULATOR_FOLDERS) ? folder : 0;
+            _command[6] = (uint8_t)parameter;
+        }
+            // fall through - continue as play folder/file
+        case 0x0F: { // play folder/file
+            uint8_t folder = _command[5];
+            uint8_t file = _command[6];
+            if (!_cardPresent) {
+                reply(0x40, EMULATOR_ERROR_BUSY, _responseDelay);
+            } else if (folder == 0 || folder >= DFPLAYER_EMULATOR_FOLDERS || file == 0 || file > _fileCount[folder]) {
+                reply(0x40, EMULATOR_ERROR_FILE_MISMATCH, _responseDelay);
+            } else {
+                _playFolder = folder;
+                _playFile = file;
+                _paused = false;
+                _playStart = millis();
+            }
+            break;
+        }
+        case 0x04: if (_volume < 30) _volume++; break;
+        case 0x05: if (_volume > 0) _volume--; break;
+        case 0x06: _volume = (parameter > 30) ? 30 : parameter; break;
+        case 0x07: _eq = parameter; break;
+        case 0x0C: reset(); break;
+        case 0x0D: // resume
+            if (_playFolder != 0 && _paused) {
+                _playStart += millis() - _pausedAt;
+                _paused = false;
+            }
+            break;
+        case 0x0E: // pause
+            if (_playFolder != 0 && !_paused) {
+                _pausedAt = millis();
+                _paused = true;
+            }
+            break;
+        case 0x16: stopPlayback(); break;
+
+        // Queries. Out-of-order replies are modelled by an extra random delay.
+        case 0x42: reply(0x42, (_playFolder == 0) ? 3 : (_paused ? 2 : 1), _responseDelay); break;
+        case 0x43: reply(0x43, _volume, _responseDelay); break;
+        case 0x44: reply(0x44, _eq, _responseDelay); break;
+        case 0x48: reply(0x48, _cardPresent ? totalFiles() : 0, _responseDelay); break;
+        case 0x4C: {
+            uint16_t track = _playFile;
+            for (uint8_t i = 1; i < _playFolder; ++i) {
+                track += _fileCount[i];
+            }
+            reply(0x4C, track, _responseDelay);
+            break;
+        }
+        case 0x4E: {
+            uint8_t count = (_cardPresent && parameter < DFPLAYER_EMULATOR_FOLDERS) ? _fileCount[parameter] : 0;
+            reply(0x4E, count, _responseDelay);
+            break;
+        }
+        case 0x4F: reply(0x4F, _cardPresent ? folderCount() : 0, _responseDelay); break;
+        default:
+            break;  // accepted without effect
+    }
+}
+
+// Schedule a frame to the driver
+void DFPlayerEmulator::reply(uint8_t command, uint16_t parameter, uint16_t delayMs) {
+    if (!_powered) {
+        return;
+    }
+    if (command >= 0x42 && chance(_reorderReplies)) {
+        delayMs += random(1, 4 * _responseDelay + 2);
+    }
+    for (uint8_t i = 0; i < DFPLAYER_EMULATOR_FRAMES; ++i) {
+        if (!_frameUsed[i]) {
+            _frameUsed[i] = true;
+            _frameCommand[i] = command;
+            _frameParameter[i] = parameter;
+            _frameDue[i] = millis() + delayMs;
+            return;
+        }
+    }
+    _bytesLost += 10;  // module busy, the frame is lost
+}
+
+void DFPlayerEmulator::reset() {
+    stopPlayback();
+    _volume = 30;
+    _eq = 0;
+    _online = false;
+    _onlineAt = millis() + _resetDuration;
+    if (_cardPresent) {
+        reply(0x3F, EMULATOR_DEVICE_SD, _resetDuration);
+    }
+}
+
+void DFPlayerEmulator::stopPlayback() {
+    _playFolder = 0;
+    _playFile = 0;
+    _paused = false;
+}
+
+uint16_t DFPlayerEmulator::totalFiles() {
+    uint16_t total = 0;
+    for (uint8_t i = 1; i < DFPLAYER_EMULATOR_FOLDERS; ++i) {
+        total += _fileCount[i];
+    }
+    return total;
+}
+
+uint8_t DFPlayerEmulator::folderCount() {
+    uint8_t count = 0;
+    for (uint8_t i = 1; i < DFPLAYER_EMULATOR_FOLDERS; ++i) {
+        if (_fileCount[i] > 0) count++;
+    }
+    return count;
+}
+
+bool DFPlayerEmulator::chance(uint16_t perMille) {
+    return perMille != 0 && random(1000) < perMille;
+}
+
+void DFPlayerEmulator::pushByte(uint8_t byteOut) {
+    if (_rxCount >= DFPLAYER_EMULATOR_RX_SIZE) {
+        _bytesLost++;  // receive buffer overflow, like SoftwareSerial
+        return;
+    }
+    _rx[(_rxHead + _rxCount) % DFPLAYER_EMULATOR_RX_SIZE] = byteOut;
+    _rxCount++;
+}
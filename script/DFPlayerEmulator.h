@@ -0,0 +1,141 @@
+/*!
+ * @file DFPlayerEmulator.h
+ * @brief Emulation of a DFPlayer Mini module behind the Arduino Stream interface
+ *
+ * Pass an instance to DFRobotDFPlayerMini::begin() instead of the serial port. It implements the
+ * 10-byte framing and checksums, ACK (0x41) replies, query responses and the unsolicited events
+ * (play finished, card inserted/removed, online), driven by millis(). It only uses the Arduino API,
+ * so it runs on the board (bench testing without a module, see DFPLAYER_EMULATOR in script.ino)
+ * as well as in a workstation build on top of an Arduino core emulation.
+ *
+ * Configurable:
+ *  - Timing: ACK and response latency, reset duration and the transfer time per byte.
+ *  - SD card model: file count and clip duration per folder. Override fileDuration() for per-file durations.
+ *  - Fault injection (per mille): dropped bytes, bad checksums, duplicate frames and out-of-order replies.
+ */
+
+#ifndef DFPlayerEmulator_h
+#define DFPlayerEmulator_h
+
+#include <Arduino.h>
+
+#ifndef DFPLAYER_EMULATOR_FOLDERS
+#define DFPLAYER_EMULATOR_FOLDERS 16      // folders 1..15 can hold files
+#endif
+#ifndef DFPLAYER_EMULATOR_FRAMES
+#define DFPLAYER_EMULATOR_FRAMES 8        // replies/events waiting for their due time
+#endif
+#ifndef DFPLAYER_EMULATOR_RX_SIZE
+#define DFPLAYER_EMULATOR_RX_SIZE 64      // bytes readable by the driver (same as the SoftwareSerial buffer)
+#endif
+
+class DFPlayerEmulator : public Stream {
+public:
+    DFPlayerEmulator();
+    virtual ~DFPlayerEmulator() {}
+
+    // Same calls as SoftwareSerial, so the emulator can replace it. begin() powers the module up.
+    void begin(long speed);
+    void end();
+
+    // Stream interface (the DFPlayer side of the serial line)
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t byteIn) override;
+    using Print::write;
+
+    // SD card model
+    void setFolder(uint8_t folder, uint8_t fileCount, uint16_t durationMs); // fileCount 0 removes the folder
+    void insertCard();                    // Sends "card inserted" and, after the reset time, "card online"
+    void removeCard();                    // Stops playback and sends "card removed"
+
+    // Timing (ms)
+    void setAckDelay(uint16_t ms)       { _ackDelay = ms; }
+    void setResponseDelay(uint16_t ms)  { _responseDelay = ms; }
+    void setResetDuration(uint16_t ms)  { _resetDuration = ms; }
+    void setByteTime(uint8_t ms)        { _byteTime = ms; }  // 0: frames arrive at once, 1: about 9600 baud
+
+    // Fault injection, probabilities in per mille (0 = off)
+    void setDropBytes(uint16_t perMille)       { _dropBytes = perMille; }
+    void setBadChecksums(uint16_t perMille)    { _badChecksums = perMille; }
+    void setDuplicateFrames(uint16_t perMille) { _duplicateFrames = perMille; }
+    void setReorderReplies(uint16_t perMille)  { _reorderReplies = perMille; }
+
+    // Observation
+    bool isPlaying();
+    uint8_t playingFolder()  { return _playFolder; }
+    uint8_t playingFile()    { return _playFile; }
+    uint8_t volume()         { return _volume; }
+    uint16_t framesReceived()  { return _framesReceived; }
+    uint16_t framesRejected()  { return _framesRejected; }  // bad checksum or framing from the driver
+    uint16_t framesSent()      { return _framesSent; }
+    uint16_t bytesLost()       { return _bytesLost; }       // dropped by injection or receive buffer overflow
+
+protected:
+    // Duration of one clip; default: the duration configured for its folder
+    virtual uint16_t fileDuration(uint8_t folder, uint8_t file);
+
+private:
+    // Frame assembly of bytes written by the driver
+    uint8_t _command[10];
+    uint8_t _commandIndex;
+
+    // Replies and events waiting for their due time
+    uint8_t _frameCommand[DFPLAYER_EMULATOR_FRAMES];
+    uint16_t _frameParameter[DFPLAYER_EMULATOR_FRAMES];
+    uint32_t _frameDue[DFPLAYER_EMULATOR_FRAMES];
+    bool _frameUsed[DFPLAYER_EMULATOR_FRAMES];
+
+    // Frame currently transferred byte by byte into the receive buffer
+    uint8_t _outFrame[10];
+    uint8_t _outIndex;                  // 10 = nothing in transfer
+    uint32_t _nextByteTime;
+
+    // Receive buffer of the driver
+    uint8_t _rx[DFPLAYER_EMULATOR_RX_SIZE];
+    uint8_t _rxHead;
+    uint8_t _rxCount;
+
+    // Module state
+    uint8_t _fileCount[DFPLAYER_EMULATOR_FOLDERS];
+    uint16_t _duration[DFPLAYER_EMULATOR_FOLDERS];
+    bool _powered;
+    bool _cardPresent;
+    bool _online;                       // false while resetting
+    uint32_t _onlineAt;
+    uint8_t _volume;
+    uint8_t _eq;
+    uint8_t _playFolder;                // 0 = stopped
+    uint8_t _playFile;
+    bool _paused;
+    uint32_t _playStart;
+    uint32_t _pausedAt;
+
+    uint16_t _ackDelay;
+    uint16_t _responseDelay;
+    uint16_t _resetDuration;
+    uint8_t _byteTime;
+
+    uint16_t _dropBytes;
+    uint16_t _badChecksums;
+    uint16_t _duplicateFrames;
+    uint16_t _reorderReplies;
+
+    uint16_t _framesReceived;
+    uint16_t _framesRejected;
+    uint16_t _framesSent;
+    uint16_t _bytesLost;
+
+    void update();                                          // Advance playback, timers and byte transfer
+    void executeCommand();                                  // Act on the complete frame in _command
+    void reply(uint8_t command, uint16_t parameter, uint16_t delayMs);
+    void reset();
+    void stopPlayback();
+    uint16_t totalFiles();
+    uint8_t folderCount();
+    bool chance(uint16_t perMille);
+    void pushByte(uint8_t byteOut);
+};
+
+#endif  // DFPlayerEmulator_h
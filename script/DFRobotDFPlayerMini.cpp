@@ -39,8 +39,17 @@ void DFRobotDFPlayerMini::disableACK() {
 bool DFRobotDFPlayerMini::begin(Stream &stream, bool isACK, bool doReset) {
     _serial = &stream;
     _receivedIndex = 0;
-    _isAvailable = false;
     _isSending = false;
+    _lateAck = false;
+    _eventHead = 0;
+    _eventCount = 0;
+    // Start with an empty send queue; the first frame may go out immediately
+    _queueHead = 0;
+    _queueCount = 0;
+    _timeOutTimer = millis() - DFPLAYER_SEND_INTERVAL;
+    for (uint8_t i = 0; i < DFPLAYER_QUERY_SLOTS; ++i) {
+        _queryCallback[i] = nullptr;
+    }
     // Configure ACK mode based on parameter
     if (isACK) enableACK();
     else       disableACK();
@@ -52,26 +61,24 @@ bool DFRobotDFPlayerMini::begin(Stream &stream, bool isACK, bool doReset) {
         waitAvailable(2000);
         // Give an extra brief delay to allow DFPlayer initialization events to finish
         delay(200);
-    } else {
-        // Without reset, assume the device is already online (simulate CardOnline event)
-        _handleType = DFPlayerCardOnline;
-        _isAvailable = false;
+        available();
+    }
+    // Without reset, assume the device is already online.
+    // Otherwise look through the initialization events for a card/USB online event.
+    bool online = !doReset;
+    uint8_t type;
+    uint16_t parameter;
+    while (readEvent(type, parameter)) {
+        if (type == DFPlayerCardOnline || type == DFPlayerUSBOnline) {
+            online = true;
+        }
     }
     // The begin is successful if either we detected a card/USB online event, or if ACK is disabled (cannot verify)
-    uint8_t type = readType();
-    return (type == DFPlayerCardOnline || type == DFPlayerUSBOnline || !isACK);
+    return (online || !isACK);
 }
 
 // Send the current frame in _sending buffer over serial.
 void DFRobotDFPlayerMini::sendStack() {
-    if (_sending[4] == 0x01) {  // ACK requested
-        // If waiting for a previous ACK, ensure it's done before sending a new command
-        // (This prevents buffer overflow by not piling up commands.)
-        while (_isSending) {
-            yield();            // yield to avoid blocking (feeds watchdog on ESP)
-            waitAvailable();    // process incoming data (which might include the awaited ACK)
-        }
-    }
 #ifdef DFPLAYER_DEBUG
     // Print out the bytes being sent for debugging
     Serial.print(F("[DFPlayer Debug] Sending: "));
@@ -83,14 +90,13 @@ void DFRobotDFPlayerMini::sendStack() {
 #endif
     // Write all 10 bytes of the command frame to the serial port
     _serial->write(_sending, DFPLAYER_SEND_LENGTH);
+    if (_frameTap) {
+        _frameTap(false, _sending[Stack_Command], arrayToUint16(_sending + Stack_Parameter));
+    }
 
     _timeOutTimer = millis();
     // If ACK is requested, mark as waiting for ACK; if not, we are not in a waiting state.
     _isSending = (_sending[4] == 0x01);
-    if (!_isSending) {
-        // If not expecting an ACK, insert a small delay to avoid sending commands too rapidly
-        delay(10);
-    }
 }
 
 // Overloads for sendStack with different parameter types:
@@ -98,22 +104,91 @@ void DFRobotDFPlayerMini::sendStack(uint8_t command) {
     sendStack(command, (uint16_t)0);
 }
 void DFRobotDFPlayerMini::sendStack(uint8_t command, uint16_t argument) {
-    _sending[3] = command;                     // Stack_Command index (3)
-    uint16ToArray(argument, _sending + 5);     // place argument into Stack_Parameter (index 5-6)
-    uint16ToArray(calculateCheckSum(_sending), _sending + 7);  // compute checksum into index 7-8
-    _sending[9] = 0xEF;                        // end byte
-    sendStack();
+    if (_queueCount >= DFPLAYER_SEND_QUEUE_SIZE) {
+        // Queue full – drop the command instead of blocking the caller
+        _droppedCommands++;
+#ifdef DFPLAYER_DEBUG
+        Serial.println(F("[DFPlayer Debug] Send queue full, command dropped"));
+#endif
+        return;
+    }
+    uint8_t tail = (_queueHead + _queueCount) % DFPLAYER_SEND_QUEUE_SIZE;
+    _queueCommand[tail] = command;
+    _queueParameter[tail] = argument;
+    _queueCount++;
+    // Send right away if the line is free, otherwise available() will do it later
+    processQueue();
 }
 void DFRobotDFPlayerMini::sendStack(uint8_t command, uint8_t argHigh, uint8_t argLow) {
     uint16_t arg = ((uint16_t)argHigh << 8) | argLow;
     sendStack(command, arg);
 }
 
+// Advance the send queue by at most one frame. Never blocks.
+void DFRobotDFPlayerMini::processQueue() {
+    if (_isSending) {
+        // Still waiting for the ACK of the command in flight
+        if (millis() - _timeOutTimer < DFPLAYER_ACK_TIMEOUT) {
+            return;
+        }
+        if (_sendRetries < DFPLAYER_SEND_RETRIES) {
+            // ACK timed out, _sending still holds the frame: send it again
+            _sendRetries++;
+            _retransmittedCommands++;
+            sendStack();
+            return;
+        }
+        // Out of retries, give up on this command and continue with the next one
+        _droppedCommands++;
+        dequeueCommand();
+    }
+    if (_queueCount == 0 || millis() - _timeOutTimer < DFPLAYER_SEND_INTERVAL) {
+        return;
+    }
+    _sending[3] = _queueCommand[_queueHead];                   // Stack_Command index (3)
+    uint16ToArray(_queueParameter[_queueHead], _sending + 5);  // place argument into Stack_Parameter (index 5-6)
+    uint16ToArray(calculateCheckSum(_sending), _sending + 7);  // compute checksum into index 7-8
+    _sending[9] = 0xEF;                                        // end byte
+    _sendRetries = 0;
+    sendStack();
+    if (!_isSending) {
+        // No ACK expected, the command is done once it is on the line
+        dequeueCommand();
+    }
+}
+
+// Remove the command at the head of the queue (the one in flight)
+void DFRobotDFPlayerMini::dequeueCommand() {
+    if (_queueCount > 0) {
+        _queueHead = (_queueHead + 1) % DFPLAYER_SEND_QUEUE_SIZE;
+        _queueCount--;
+    }
+    _isSending = false;
+}
+
+uint8_t DFRobotDFPlayerMini::pendingCommands() {
+    return _queueCount;
+}
+
+uint16_t DFRobotDFPlayerMini::droppedCommands() {
+    return _droppedCommands;
+}
+
+uint16_t DFRobotDFPlayerMini::retransmittedCommands() {
+    return _retransmittedCommands;
+}
+
 // Check if data is available from DFPlayer, and parse frames. 
 // Returns true if a complete message (event) was received.
 bool DFRobotDFPlayerMini::available() {
-    // Read as many bytes as available, one at a time, to assemble frames.
-    while (_serial->available()) {
+    // Transmit the next queued command (or retransmit on ACK timeout) before looking at incoming data
+    processQueue();
+    expireQueries();
+    // Read the available bytes, one at a time, to assemble frames. At most DFPLAYER_PARSE_BUDGET
+    // bytes per call, so a burst of noise cannot stall the caller; the rest is read on the next call.
+    uint8_t budget = DFPLAYER_PARSE_BUDGET;
+    while (budget > 0 && _serial->available()) {
+        budget--;
         uint8_t byteIn = _serial->read();
 #ifdef DFPLAYER_DEBUG
         Serial.print(F("[DFPlayer Debug] Received byte: 0x"));
@@ -142,7 +217,8 @@ bool DFRobotDFPlayerMini::available() {
 #ifdef DFPLAYER_DEBUG
                 Serial.println(F("<< Invalid version byte, discarding frame"));
 #endif
-                return handleError(WrongStack);  // handle error (sets _isSending=false, etc.)
+                rejectFrame(2);
+                continue;
             }
         }
         // If we just stored the third byte, verify length (should be 0x06 for all standard frames)
@@ -151,7 +227,8 @@ bool DFRobotDFPlayerMini::available() {
 #ifdef DFPLAYER_DEBUG
                 Serial.println(F("<< Invalid length byte, discarding frame"));
 #endif
-                return handleError(WrongStack);
+                rejectFrame(3);
+                continue;
             }
         }
         // If we have read the full frame length (10 bytes):
@@ -160,42 +237,68 @@ bool DFRobotDFPlayerMini::available() {
 #ifdef DFPLAYER_DEBUG
             Serial.println(F("<= End of frame received"));
 #endif
-            _receivedIndex = 0;  // reset index for next frame assembly
             // Verify start and end bytes, and checksum
             if (_received[0] != 0x7E || _received[9] != 0xEF) {
                 // Invalid frame markers
 #ifdef DFPLAYER_DEBUG
                 Serial.println(F("<< Frame start/end byte error"));
 #endif
-                return handleError(WrongStack);
+                rejectFrame(DFPLAYER_RECEIVED_LENGTH);
+                continue;
             }
             if (!validateStack()) {
                 // Checksum mismatch
 #ifdef DFPLAYER_DEBUG
                 Serial.println(F("<< Checksum error"));
 #endif
-                return handleError(WrongStack);
+                rejectFrame(DFPLAYER_RECEIVED_LENGTH);
+                continue;
             }
-            // Frame is valid – parse the content
-            parseStack();
-            // If the parsed frame was an ACK (0x41) it won't set _isAvailable, just clears _isSending.
-            // Continue reading any further bytes in buffer (do not return true yet in that case).
-            if (_isAvailable) {
-                // A non-ACK event is ready for user consumption
-                return true;
+            _receivedIndex = 0;  // reset index for next frame assembly
+            _receivedFrames++;
+            if (_frameTap) {
+                _frameTap(true, _received[Stack_Command], arrayToUint16(_received + Stack_Parameter));
             }
-            // If it was only an ACK, loop continues to check next bytes (if any)
+            // Frame is valid – parse the content. Events are queued, so keep reading further frames.
+            parseStack();
         }
     }
     // If we exit the loop, either no more data or only partial frame collected.
-    return _isAvailable;
+    return _eventCount > 0;
+}
+
+// Report a broken frame and resynchronize. The bytes after the start byte may already contain the
+// beginning of the next frame (e.g. after a lost byte), so assembly restarts at the next 0x7E that
+// can still begin a valid frame instead of dropping everything that was received.
+void DFRobotDFPlayerMini::rejectFrame(uint8_t length) {
+    _rejectedFrames++;
+    handleError(WrongStack);  // queues the error and resets frame assembly
+    for (uint8_t start = 1; start < length; ++start) {
+        uint8_t remaining = length - start;
+        if (_received[start] == 0x7E &&
+            (remaining < 2 || _received[start + 1] == 0xFF) &&
+            (remaining < 3 || _received[start + 2] == 0x06)) {
+            // Less than a full frame remains, so only the header bytes have to be checked here
+            memmove(_received, _received + start, remaining);
+            _receivedIndex = remaining;
+            return;
+        }
+    }
+}
+
+uint16_t DFRobotDFPlayerMini::receivedFrames() {
+    return _receivedFrames;
+}
+
+uint16_t DFRobotDFPlayerMini::rejectedFrames() {
+    return _rejectedFrames;
 }
 
 // Wait for data to be available for up to the specified duration.
 // This will repeatedly call available() until an event is ready or timeout occurs.
-bool DFRobotDFPlayerMini::waitAvailable(unsigned long duration) {
+bool DFRobotDFPlayerMini::waitAvailable(uint32_t duration) {
     if (duration == 0) duration = _timeOutDuration;
-    unsigned long startTime = millis();
+    uint32_t startTime = millis();
     // Loop until available() returns true (event ready) or timeout elapses
     while (!available()) {
         if (millis() - startTime >= duration) {
@@ -213,51 +316,67 @@ bool DFRobotDFPlayerMini::waitAvailable(unsigned long duration) {
 // Once a full frame is validated, this function interprets the command and parameters.
 void DFRobotDFPlayerMini::parseStack() {
     uint8_t cmd = _received[3];  // Command byte from frame
+    // An ACK carries no command byte. When the response to a query overtook its ACK, the first ACK
+    // that follows belongs to that query and must not settle the next command in flight.
+    if (cmd == 0x41 && _lateAck) {
+        _lateAck = false;
+        if (millis() - _lateAckTimer < DFPLAYER_ACK_TIMEOUT) {
+            return;
+        }
+    }
+    // The command in flight is settled by its ACK, by its query response, by an error report
+    // (the module answers with 0x40 instead of an ACK) or by the online message after a reset.
+    if (_isSending &&
+        (cmd == 0x41 || cmd == 0x40 || cmd == _sending[3] || (cmd == 0x3F && _sending[3] == 0x0C))) {
+        if (cmd == _sending[3]) {
+            _lateAck = true;
+            _lateAckTimer = _timeOutTimer;
+        }
+        dequeueCommand();
+        processQueue();  // the line is free again, send the next command without waiting for the next poll
+    }
     // Special case: ACK response (0x41) – this just indicates the module received a command.
     if (cmd == 0x41) {
-        // Received ACK, no user-facing event. Just mark the sending as completed.
-        _isSending = false;
+        // Received ACK, no user-facing event.
         return;
     }
-    // Store the command and parameter for user retrieval
-    _handleCommand = cmd;
-    _handleParameter = arrayToUint16(_received + 5);
+    uint16_t parameter = arrayToUint16(_received + 5);
     // Determine the type of event based on command code
     switch (cmd) {
         case 0x3C: // U-disk finished playing current track
         case 0x3D: // TF card finished playing current track
         case 0x3E: // Flash finished playing current track
             // All of these indicate a track finished playing on some device
-            handleMessage(DFPlayerPlayFinished, _handleParameter);
+            handleMessage(DFPlayerPlayFinished, parameter, cmd);
             break;
         case 0x3A: // Card or USB inserted
-            if (_handleParameter & 0x01) {
-                handleMessage(DFPlayerUSBInserted, _handleParameter);
-            } else if (_handleParameter & 0x02) {
-                handleMessage(DFPlayerCardInserted, _handleParameter);
+            if (parameter & 0x01) {
+                handleMessage(DFPlayerUSBInserted, parameter, cmd);
+            } else if (parameter & 0x02) {
+                handleMessage(DFPlayerCardInserted, parameter, cmd);
             }
             break;
         case 0x3B: // Card or USB removed
-            if (_handleParameter & 0x01) {
-                handleMessage(DFPlayerUSBRemoved, _handleParameter);
-            } else if (_handleParameter & 0x02) {
-                handleMessage(DFPlayerCardRemoved, _handleParameter);
+            if (parameter & 0x01) {
+                handleMessage(DFPlayerUSBRemoved, parameter, cmd);
+            } else if (parameter & 0x02) {
+                handleMessage(DFPlayerCardRemoved, parameter, cmd);
             }
             break;
         case 0x3F: // Device online (initialization result after reset)
             // 0x3F returns a parameter indicating which devices are online (bitmask)
             // 0x01 = USB, 0x02 = SD, 0x04 = PC (not used here). Combine bits means both.
-            if (_handleParameter & 0x01 && _handleParameter & 0x02) {
-                handleMessage(DFPlayerCardUSBOnline, _handleParameter);
-            } else if (_handleParameter & 0x01) {
-                handleMessage(DFPlayerUSBOnline, _handleParameter);
-            } else if (_handleParameter & 0x02) {
-                handleMessage(DFPlayerCardOnline, _handleParameter);
+            if (parameter & 0x01 && parameter & 0x02) {
+                handleMessage(DFPlayerCardUSBOnline, parameter, cmd);
+            } else if (parameter & 0x01) {
+                handleMessage(DFPlayerUSBOnline, parameter, cmd);
+            } else if (parameter & 0x02) {
+                handleMessage(DFPlayerCardOnline, parameter, cmd);
             }
             break;
         case 0x40: // Error report from DFPlayer
-            // The _handleParameter contains an error code (1-7) corresponding to Busy, Sleeping, etc.
-            handleMessage(DFPlayerError, _handleParameter);
+            // The parameter contains an error code (1-7) corresponding to Busy, Sleeping, etc.
+            handleMessage(DFPlayerError, parameter, cmd);
             break;
         case 0x42: // Query current status (response to 0x42 command)
         case 0x43: // Query current volume
@@ -272,8 +391,11 @@ void DFRobotDFPlayerMini::parseStack() {
         case 0x4D: // Query flash current file
         case 0x4E: // Query folder file count
         case 0x4F: // Query folder count
-            // All these queries respond with a value, which we store as generic feedback
-            handleMessage(DFPlayerFeedBack, _handleParameter);
+            // All these queries respond with a value. An outstanding asynchronous query takes it,
+            // otherwise we store it as generic feedback
+            if (!resolveQuery(cmd, parameter)) {
+                handleMessage(DFPlayerFeedBack, parameter, cmd);
+            }
             break;
         default:
             // Unknown or unexpected command
@@ -300,14 +422,27 @@ bool DFRobotDFPlayerMini::validateStack() {
     return (expectedCheckSum == receivedCheckSum);
 }
 
-// Handle a normal message event: set state for readType() and read()
-bool DFRobotDFPlayerMini::handleMessage(uint8_t type, uint16_t parameter) {
-    _handleType = type;
-    _handleParameter = parameter;
-    _isAvailable = true;   // mark that an event is ready to be read
-    _isSending = false;    // in case we were waiting for an ACK, it's done now
+// Handle a normal message event: queue it for readType()/read() and readEvent()
+bool DFRobotDFPlayerMini::handleMessage(uint8_t type, uint16_t parameter, uint8_t command) {
     // Reset index to start looking for next frame (in case not already reset)
     _receivedIndex = 0;
+    uint8_t newest = (_eventHead + _eventCount + DFPLAYER_EVENT_QUEUE_SIZE - 1) % DFPLAYER_EVENT_QUEUE_SIZE;
+    if ((type == TimeOut || type == WrongStack) && _eventCount > 0 && _eventType[newest] == type) {
+        // A burst of noise or timeouts is reported once, so it cannot push real events out of the queue
+        return true;
+    }
+    if (_eventCount >= DFPLAYER_EVENT_QUEUE_SIZE) {
+        _droppedEvents++;
+#ifdef DFPLAYER_DEBUG
+        Serial.println(F("[DFPlayer Debug] Event queue full, event dropped"));
+#endif
+        return true;
+    }
+    uint8_t tail = (_eventHead + _eventCount) % DFPLAYER_EVENT_QUEUE_SIZE;
+    _eventType[tail] = type;
+    _eventParameter[tail] = parameter;
+    _eventCommand[tail] = command;
+    _eventCount++;
 #ifdef DFPLAYER_DEBUG
     Serial.print(F("[DFPlayer Debug] Event: type="));
     Serial.print(type);
@@ -320,38 +455,110 @@ bool DFRobotDFPlayerMini::handleMessage(uint8_t type, uint16_t parameter) {
 // Handle an error event: treat it as a message but return false (for internal use)
 bool DFRobotDFPlayerMini::handleError(uint8_t type, uint16_t parameter) {
     handleMessage(type, parameter);
-    _isSending = false;
-    // We do not set _isAvailable to false here; the error can be retrieved via readType/read if needed.
+    // The send queue is not touched here; an unacknowledged command is retried by processQueue().
+    // The error is queued and can be retrieved via readType/read if needed.
     return false;
 }
 
-// Retrieve the last message type and reset availability flag
+// Take the oldest queued message; its parameter and command stay readable via read()/readCommand().
+// With an empty queue the previously taken message is returned again.
 uint8_t DFRobotDFPlayerMini::readType() {
-    uint8_t t = _handleType;
-    _isAvailable = false;  // clear the flag after reading
-    return t;
+    if (_eventCount > 0) {
+        _handleType = _eventType[_eventHead];
+        _handleParameter = _eventParameter[_eventHead];
+        _handleCommand = _eventCommand[_eventHead];
+        _eventHead = (_eventHead + 1) % DFPLAYER_EVENT_QUEUE_SIZE;
+        _eventCount--;
+    }
+    return _handleType;
 }
 
-// Retrieve the last message parameter (16-bit) and reset availability flag
+// Retrieve the parameter (16-bit) of the message taken by readType()
 uint16_t DFRobotDFPlayerMini::read() {
-    uint16_t param = _handleParameter;
-    _isAvailable = false;
-    return param;
+    return _handleParameter;
 }
 
-// Retrieve the last command byte received (for low-level debugging)
+// Retrieve the command byte of the message taken by readType() (for low-level debugging)
 uint8_t DFRobotDFPlayerMini::readCommand() {
     return _handleCommand;
 }
 
+bool DFRobotDFPlayerMini::readEvent(uint8_t &type, uint16_t &parameter) {
+    if (_eventCount == 0) {
+        return false;
+    }
+    type = readType();
+    parameter = read();
+    return true;
+}
+
+uint8_t DFRobotDFPlayerMini::pendingEvents() {
+    return _eventCount;
+}
+
+uint16_t DFRobotDFPlayerMini::droppedEvents() {
+    return _droppedEvents;
+}
+
+// Take the event at position (counted from the head) out of the queue, the younger events keep their order
+void DFRobotDFPlayerMini::removeEvent(uint8_t position) {
+    // Close the gap by moving the younger events one slot towards the head
+    for (uint8_t j = position + 1; j < _eventCount; ++j) {
+        uint8_t from = (_eventHead + j) % DFPLAYER_EVENT_QUEUE_SIZE;
+        uint8_t to = (_eventHead + j - 1) % DFPLAYER_EVENT_QUEUE_SIZE;
+        _eventType[to] = _eventType[from];
+        _eventParameter[to] = _eventParameter[from];
+        _eventCommand[to] = _eventCommand[from];
+    }
+    _eventCount--;
+}
+
+// Send a query and wait for its response. A response to the same command still queued from an earlier
+// query that timed out is stale, it is dropped so that it cannot answer this one.
+int DFRobotDFPlayerMini::readQuery(uint8_t command, uint16_t argument) {
+    for (uint8_t i = _eventCount; i > 0; --i) {
+        uint8_t index = (_eventHead + i - 1) % DFPLAYER_EVENT_QUEUE_SIZE;
+        if (_eventType[index] == DFPlayerFeedBack && _eventCommand[index] == command) {
+            removeEvent(i - 1);
+        }
+    }
+    sendStack(command, argument);
+    return waitFeedBack(command);
+}
+
+// Wait for the DFPlayerFeedBack event of command and take it out of the queue. Other events, including
+// responses to other commands, stay queued in order.
+int DFRobotDFPlayerMini::waitFeedBack(uint8_t command) {
+    uint32_t startTime = millis();
+    while (true) {
+        available();
+        for (uint8_t i = 0; i < _eventCount; ++i) {
+            uint8_t index = (_eventHead + i) % DFPLAYER_EVENT_QUEUE_SIZE;
+            if (_eventType[index] != DFPlayerFeedBack || _eventCommand[index] != command) {
+                continue;
+            }
+            int value = (int)_eventParameter[index];
+            removeEvent(i);
+            return value;
+        }
+        if (millis() - startTime >= _timeOutDuration) {
+            // Timeout occurred, register a TimeOut error
+            handleError(TimeOut);
+            return -1;
+        }
+        // Yield to prevent watchdog reset (especially on ESP8266/ESP32)
+        yield();
+    }
+}
+
 // Set a custom timeout duration (in milliseconds) for waiting on responses/ACKs
-void DFRobotDFPlayerMini::setTimeOut(unsigned long timeOutDuration) {
+void DFRobotDFPlayerMini::setTimeOut(uint32_t timeOutDuration) {
     _timeOutDuration = timeOutDuration;
 }
 
 /** 
  * Below are the implementations of all control and query methods.
- * Each sends the corresponding command to the DFPlayer. 
+ * Each queues the corresponding command for the DFPlayer and returns immediately.
  * Query functions will wait for a response and return the result, or -1 on error.
  */
 void DFRobotDFPlayerMini::next() {
@@ -456,86 +663,43 @@ void DFRobotDFPlayerMini::disableDAC() {
 }
 
 // Query functions: send query command and wait for response, returning the result or -1 on error.
+// Events arriving meanwhile (e.g. DFPlayerPlayFinished) stay queued for the caller.
 int DFRobotDFPlayerMini::readState() {
-    sendStack(0x42);
-    if (waitAvailable()) {
-        // Check if the response type is DFPlayerFeedBack (which holds the data for queries)
-        if (readType() == DFPlayerFeedBack) {
-            return (int)read();
-        }
-    }
-    return -1; // on timeout or wrong type
+    // Wait for the DFPlayerFeedBack event (which holds the data for queries), -1 on timeout
+    return readQuery(0x42);
 }
 int DFRobotDFPlayerMini::readVolume() {
-    sendStack(0x43);
-    if (waitAvailable()) {
-        if (readType() == DFPlayerFeedBack) {
-            return (int)read();
-        }
-    }
-    return -1;
+    return readQuery(0x43);
 }
 int DFRobotDFPlayerMini::readEQ() {
-    sendStack(0x44);
-    if (waitAvailable()) {
-        if (readType() == DFPlayerFeedBack) {
-            return (int)read();
-        }
-    }
-    return -1;
+    return readQuery(0x44);
 }
 int DFRobotDFPlayerMini::readFileCounts(uint8_t device) {
     // Send appropriate query based on device code
     if (device == DFPLAYER_DEVICE_U_DISK) {
-        sendStack(0x47);
+        return readQuery(0x47);
     } else if (device == DFPLAYER_DEVICE_SD) {
-        sendStack(0x48);
+        return readQuery(0x48);
     } else if (device == DFPLAYER_DEVICE_FLASH) {
-        sendStack(0x49);
-    } else {
-        return -1; // invalid device
+        return readQuery(0x49);
     }
-    if (waitAvailable()) {
-        if (readType() == DFPlayerFeedBack) {
-            return (int)read();
-        }
-    }
-    return -1;
+    return -1; // invalid device
 }
 int DFRobotDFPlayerMini::readCurrentFileNumber(uint8_t device) {
     if (device == DFPLAYER_DEVICE_U_DISK) {
-        sendStack(0x4B);
+        return readQuery(0x4B);
     } else if (device == DFPLAYER_DEVICE_SD) {
-        sendStack(0x4C);
+        return readQuery(0x4C);
     } else if (device == DFPLAYER_DEVICE_FLASH) {
-        sendStack(0x4D);
-    } else {
-        return -1;
-    }
-    if (waitAvailable()) {
-        if (readType() == DFPlayerFeedBack) {
-            return (int)read();
-        }
+        return readQuery(0x4D);
     }
     return -1;
 }
 int DFRobotDFPlayerMini::readFileCountsInFolder(int folderNumber) {
-    sendStack(0x4E, (uint16_t)folderNumber);
-    if (waitAvailable()) {
-        if (readType() == DFPlayerFeedBack) {
-            return (int)read();
-        }
-    }
-    return -1;
+    return readQuery(0x4E, (uint16_t)folderNumber);
 }
 int DFRobotDFPlayerMini::readFolderCounts() {
-    sendStack(0x4F);
-    if (waitAvailable()) {
-        if (readType() == DFPlayerFeedBack) {
-            return (int)read();
-        }
-    }
-    return -1;
+    return readQuery(0x4F);
 }
 int DFRobotDFPlayerMini::readFileCounts() {
     // Default to SD card
@@ -545,3 +709,88 @@ int DFRobotDFPlayerMini::readCurrentFileNumber() {
     // Default to SD card
     return readCurrentFileNumber(DFPLAYER_DEVICE_SD);
 }
+
+// Asynchronous queries: reserve a slot and queue the query command. The response is matched in parseStack().
+bool DFRobotDFPlayerMini::query(uint8_t command, uint16_t argument, DFPlayerQueryCallback callback) {
+    if (callback == nullptr) {
+        return false;
+    }
+    for (uint8_t i = 0; i < DFPLAYER_QUERY_SLOTS; ++i) {
+        if (_queryCallback[i] == nullptr) {
+            _queryCallback[i] = callback;
+            _queryCommand[i] = command;
+            _queryOrder[i] = _querySequence++;
+            _queryTime[i] = millis();
+            sendStack(command, argument);
+            return true;
+        }
+    }
+    return false; // all slots in use
+}
+bool DFRobotDFPlayerMini::queryState(DFPlayerQueryCallback callback) {
+    return query(0x42, 0, callback);
+}
+bool DFRobotDFPlayerMini::queryVolume(DFPlayerQueryCallback callback) {
+    return query(0x43, 0, callback);
+}
+bool DFRobotDFPlayerMini::queryEQ(DFPlayerQueryCallback callback) {
+    return query(0x44, 0, callback);
+}
+bool DFRobotDFPlayerMini::queryFileCounts(DFPlayerQueryCallback callback) {
+    return query(0x48, 0, callback);
+}
+bool DFRobotDFPlayerMini::queryCurrentFileNumber(DFPlayerQueryCallback callback) {
+    return query(0x4C, 0, callback);
+}
+bool DFRobotDFPlayerMini::queryFileCountsInFolder(int folderNumber, DFPlayerQueryCallback callback) {
+    return query(0x4E, (uint16_t)folderNumber, callback);
+}
+bool DFRobotDFPlayerMini::queryFolderCounts(DFPlayerQueryCallback callback) {
+    return query(0x4F, 0, callback);
+}
+
+uint8_t DFRobotDFPlayerMini::pendingQueries() {
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < DFPLAYER_QUERY_SLOTS; ++i) {
+        if (_queryCallback[i] != nullptr) count++;
+    }
+    return count;
+}
+
+void DFRobotDFPlayerMini::setFrameTap(DFPlayerFrameTap tap) {
+    _frameTap = tap;
+}
+
+// Hand a query response to the oldest outstanding query with the same command byte
+bool DFRobotDFPlayerMini::resolveQuery(uint8_t command, int value) {
+    int8_t oldest = -1;
+    for (uint8_t i = 0; i < DFPLAYER_QUERY_SLOTS; ++i) {
+        if (_queryCallback[i] != nullptr && _queryCommand[i] == command &&
+            (oldest < 0 || (int8_t)(_queryOrder[i] - _queryOrder[oldest]) < 0)) {
+            oldest = i;
+        }
+    }
+    if (oldest < 0) {
+        return false;
+    }
+    // Free the slot before the call, so the callback can submit the next query
+    DFPlayerQueryCallback callback = _queryCallback[oldest];
+    _queryCallback[oldest] = nullptr;
+    callback(command, value);
+    return true;
+}
+
+// Report a timeout (-1) to every query that is waiting longer than _timeOutDuration
+void DFRobotDFPlayerMini::expireQueries() {
+    for (uint8_t i = 0; i < DFPLAYER_QUERY_SLOTS; ++i) {
+        if (_queryCallback[i] != nullptr && millis() - _queryTime[i] >= _timeOutDuration) {
+            DFPlayerQueryCallback callback = _queryCallback[i];
+            _queryCallback[i] = nullptr;
+#ifdef DFPLAYER_DEBUG
+            Serial.print(F("[DFPlayer Debug] Query timed out: 0x"));
+            Serial.println(_queryCommand[i], HEX);
+#endif
+            callback(_queryCommand[i], -1);
+        }
+    }
+}
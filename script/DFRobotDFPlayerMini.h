@@ -11,6 +11,9 @@
  *  - Safe, non-blocking waits with timeouts to prevent watchdog resets (especially on ESP8266/ESP32).
  *  - Optional debug logging for sent/received data, enabled via DFPLAYER_DEBUG macro.
  *  - Thread-safe and reentrant design for multiple instances (each instance manages its own serial stream).
+ *  - Non-blocking command transmission through a ring-buffered send queue with ACK timeout and retransmit.
+ *  - Asynchronous queries: the response is delivered to a callback, several queries can be outstanding.
+ *  - Incoming events are kept in a FIFO, several frames parsed in one available() call are not lost.
  * 
  * The class and constants remain identical to the original library for drop-in replacement.
  * 
@@ -41,6 +44,38 @@
 #define DFPLAYER_RECEIVED_LENGTH 10   // length of incoming frame
 #define DFPLAYER_SEND_LENGTH 10       // length of outgoing frame
 
+// Outgoing command queue. Control methods only enqueue their command; available() writes
+// one frame at a time, waiting for the ACK (or DFPLAYER_SEND_INTERVAL without ACK) in between.
+#ifndef DFPLAYER_SEND_QUEUE_SIZE
+#define DFPLAYER_SEND_QUEUE_SIZE 8    // max. queued commands, further commands are dropped
+#endif
+#ifndef DFPLAYER_ACK_TIMEOUT
+#define DFPLAYER_ACK_TIMEOUT 200      // ms to wait for an ACK before the frame is sent again
+#endif
+#ifndef DFPLAYER_SEND_RETRIES
+#define DFPLAYER_SEND_RETRIES 2       // retransmissions before an unacknowledged command is dropped
+#endif
+#ifndef DFPLAYER_SEND_INTERVAL
+#define DFPLAYER_SEND_INTERVAL 10     // minimum ms between two outgoing frames
+#endif
+
+// Asynchronous queries waiting for their response. Responses are matched by command byte (0x42-0x4F),
+// queries with the same command byte are answered in submission order.
+#ifndef DFPLAYER_QUERY_SLOTS
+#define DFPLAYER_QUERY_SLOTS 4        // max. outstanding asynchronous queries
+#endif
+
+// Incoming events waiting for readType()/read() or readEvent()
+#ifndef DFPLAYER_EVENT_QUEUE_SIZE
+#define DFPLAYER_EVENT_QUEUE_SIZE 8   // max. queued events, further events are dropped (and counted)
+#endif
+
+// Max. bytes parsed per available() call. Bounds the worst-case time of one call; 64 bytes fill the
+// SoftwareSerial buffer, which takes more than 60 ms at 9600 baud.
+#ifndef DFPLAYER_PARSE_BUDGET
+#define DFPLAYER_PARSE_BUDGET 32
+#endif
+
 // Enable debug logging by defining DFPLAYER_DEBUG (e.g., via build flags or before including this header)
 //#define DFPLAYER_DEBUG
 
@@ -67,6 +102,12 @@
 #define FileMismatch 6    // File unable to play (mismatch or unsupported)
 #define Advertise 7       // In advertising (ADVERT) mode, cannot execute command
 
+// Callback for asynchronous queries: the query command byte and the response value, or -1 on timeout
+typedef void (*DFPlayerQueryCallback)(uint8_t command, int value);
+
+// Observer of the frames on the line: direction, command byte and parameter
+typedef void (*DFPlayerFrameTap)(bool received, uint8_t command, uint16_t parameter);
+
 #define Stack_Header      0
 #define Stack_Version     1
 #define Stack_Length      2
@@ -79,9 +120,15 @@
 class DFRobotDFPlayerMini {
 public:
     DFRobotDFPlayerMini() : 
-        _serial(nullptr), _timeOutDuration(500), _receivedIndex(0),
-        _isAvailable(false), _isSending(false),
-        _handleType(0), _handleCommand(0), _handleParameter(0) {
+        _serial(nullptr), _timeOutTimer(0), _timeOutDuration(500), _receivedIndex(0),
+        _isSending(false), _lateAck(false), _lateAckTimer(0),
+        _handleType(0), _handleCommand(0), _handleParameter(0),
+        _eventHead(0), _eventCount(0), _droppedEvents(0), _receivedFrames(0), _rejectedFrames(0),
+        _queueHead(0), _queueCount(0), _sendRetries(0),
+        _droppedCommands(0), _retransmittedCommands(0), _querySequence(0), _frameTap(nullptr) {
+        for (uint8_t i = 0; i < DFPLAYER_QUERY_SLOTS; ++i) {
+            _queryCallback[i] = nullptr;
+        }
         // Prepare the static part of the send buffer (start, version, length, end)
         _sending[0] = 0x7E;    // Start byte
         _sending[1] = 0xFF;    // Version (fixed)
@@ -103,26 +150,43 @@ public:
     bool begin(Stream &stream, bool isACK = true, bool doReset = true);
 
     // Check if the DFPlayer has sent any message (track end, feedback, error, etc.).
-    // Returns true if a new event is available to read via readType() and read().
+    // Also transmits the next queued command, so call it regularly (e.g. every loop()).
+    // Returns true if at least one event is queued, to be read via readType() and read() or readEvent().
     bool available();
 
     // Wait for an event to be available or until timeout (in milliseconds).
     // If duration is 0, uses the default _timeOutDuration. Returns true if an event arrived, false if timed out.
-    bool waitAvailable(unsigned long duration = 0);
+    bool waitAvailable(uint32_t duration = 0);
 
-    // Get the type of the last received message (one of the DFPlayer... constants above, e.g., DFPlayerPlayFinished, DFPlayerError, etc.).
+    // Take the oldest queued message and get its type (one of the DFPlayer... constants above, e.g., DFPlayerPlayFinished, DFPlayerError, etc.).
     uint8_t readType();
 
-    // Get the parameter of the last received message (e.g., track number for DFPlayerPlayFinished, error code for DFPlayerError, etc.).
+    // Get the parameter of the message taken by readType() (e.g., track number for DFPlayerPlayFinished, error code for DFPlayerError, etc.).
     uint16_t read();
 
-    // Get the last received command byte from the DFPlayer (for low-level use or debugging).
+    // Get the command byte of the message taken by readType() (for low-level use or debugging).
     uint8_t readCommand();
 
+    // Take the oldest queued message in one call. Returns false if the queue is empty.
+    bool readEvent(uint8_t &type, uint16_t &parameter);
+
+    // Event queue status
+    uint8_t pendingEvents();              // Number of queued events
+    uint16_t droppedEvents();             // Events dropped because the queue was full
+
+    // Receive statistics
+    uint16_t receivedFrames();            // Valid frames (including ACKs)
+    uint16_t rejectedFrames();            // Frames with wrong header, end byte or checksum
+
     // Set the serial communication timeout duration (milliseconds). Default is 500ms.
-    void setTimeOut(unsigned long timeOutDuration);
+    void setTimeOut(uint32_t timeOutDuration);
 
-    // Playback control methods (same as original library):
+    // Send queue status
+    uint8_t pendingCommands();            // Number of commands queued or awaiting their ACK
+    uint16_t droppedCommands();           // Commands dropped because the queue was full or no ACK arrived
+    uint16_t retransmittedCommands();     // Frames sent again after an ACK timeout
+
+    // Playback control methods (same as original library, queued and non-blocking):
     void next();                      // Play next track
     void previous();                  // Play previous track
     void play(int fileNumber);        // Play track by index (1...65535)
@@ -163,25 +227,76 @@ public:
     int readFileCounts();                 // [Alias] Read number of files on SD card (DFPLAYER_DEVICE_SD)
     int readCurrentFileNumber();          // [Alias] Read current file number on SD card (DFPLAYER_DEVICE_SD)
 
+    // Asynchronous query methods (queue the query and return immediately):
+    // The callback is called from available() with the response, or with -1 after the timeout (setTimeOut()).
+    // Returns false if all DFPLAYER_QUERY_SLOTS are in use. Responses claimed by a callback are not
+    // reported as DFPlayerFeedBack events.
+    bool query(uint8_t command, uint16_t argument, DFPlayerQueryCallback callback); // Any query command (0x42-0x4F)
+    bool queryState(DFPlayerQueryCallback callback);
+    bool queryVolume(DFPlayerQueryCallback callback);
+    bool queryEQ(DFPlayerQueryCallback callback);
+    bool queryFileCounts(DFPlayerQueryCallback callback);            // SD card
+    bool queryCurrentFileNumber(DFPlayerQueryCallback callback);     // SD card
+    bool queryFileCountsInFolder(int folderNumber, DFPlayerQueryCallback callback);
+    bool queryFolderCounts(DFPlayerQueryCallback callback);
+    uint8_t pendingQueries();             // Number of asynchronous queries waiting for their response
+
+    // Additionally hands every frame written (including retransmissions) and every valid frame received
+    // (including ACKs) to tap, e.g. to put them on a timeline. Called from available() and the control methods.
+    void setFrameTap(DFPlayerFrameTap tap);
+
 private:
     Stream* _serial;                 // Serial stream used for communication (HardwareSerial or SoftwareSerial)
-    unsigned long _timeOutTimer;     // Timer to track for timeouts
-    unsigned long _timeOutDuration;  // Duration (ms) to wait for incoming data (ACK or response)
+    uint32_t _timeOutTimer;          // Time the last frame was written (ACK timeout and send interval)
+    uint32_t _timeOutDuration;       // Duration (ms) to wait for incoming data (ACK or response)
     uint8_t _received[DFPLAYER_RECEIVED_LENGTH]; // Buffer for incoming data frame
     uint8_t _sending[DFPLAYER_SEND_LENGTH];      // Buffer for outgoing data frame
     uint8_t _receivedIndex;          // Current index in _received buffer when assembling a frame
-    bool _isAvailable;              // Flag indicating a complete message (event) is ready to be read
     bool _isSending;                // Flag indicating a command has been sent and is awaiting ACK
+    bool _lateAck;                  // A query was settled by its response before its ACK, that ACK is still due
+    uint32_t _lateAckTimer;         // Time that query was written, its ACK is not waited for after DFPLAYER_ACK_TIMEOUT
+
+    uint8_t _handleType;            // Type of the message taken by readType()
+    uint8_t _handleCommand;         // Command byte of the message taken by readType()
+    uint16_t _handleParameter;      // 16-bit parameter of the message taken by readType()
 
-    uint8_t _handleType;            // Last message type (for readType)
-    uint8_t _handleCommand;         // Last command byte received from DFPlayer
-    uint16_t _handleParameter;      // Last 16-bit parameter received from DFPlayer
+    // Event queue (ring buffer), filled by handleMessage()
+    uint8_t _eventType[DFPLAYER_EVENT_QUEUE_SIZE];
+    uint8_t _eventCommand[DFPLAYER_EVENT_QUEUE_SIZE];
+    uint16_t _eventParameter[DFPLAYER_EVENT_QUEUE_SIZE];
+    uint8_t _eventHead;
+    uint8_t _eventCount;
+    uint16_t _droppedEvents;
+    uint16_t _receivedFrames;
+    uint16_t _rejectedFrames;
+
+    // Send queue (ring buffer). The command at _queueHead is the one in flight while _isSending is set.
+    uint8_t _queueCommand[DFPLAYER_SEND_QUEUE_SIZE];
+    uint16_t _queueParameter[DFPLAYER_SEND_QUEUE_SIZE];
+    uint8_t _queueHead;
+    uint8_t _queueCount;
+    uint8_t _sendRetries;           // Retransmissions of the command in flight
+    uint16_t _droppedCommands;
+    uint16_t _retransmittedCommands;
+
+    // Outstanding asynchronous queries, a slot is free when its callback is nullptr
+    DFPlayerQueryCallback _queryCallback[DFPLAYER_QUERY_SLOTS];
+    uint8_t _queryCommand[DFPLAYER_QUERY_SLOTS];
+    uint8_t _queryOrder[DFPLAYER_QUERY_SLOTS];    // Submission sequence, to answer equal commands in order
+    uint32_t _queryTime[DFPLAYER_QUERY_SLOTS];
+    uint8_t _querySequence;
+
+    DFPlayerFrameTap _frameTap;      // Observer of the frames, nullptr if none
 
     // Internal methods for building and sending command frames
     void sendStack();                                      // Send the prepared _sending buffer over serial
-    void sendStack(uint8_t command);                       // Send command with no parameters (uses default param=0)
-    void sendStack(uint8_t command, uint16_t argument);    // Send command with 16-bit parameter
-    void sendStack(uint8_t command, uint8_t argHigh, uint8_t argLow); // Send command with two 8-bit parameters
+    void sendStack(uint8_t command);                       // Queue command with no parameters (uses default param=0)
+    void sendStack(uint8_t command, uint16_t argument);    // Queue command with 16-bit parameter
+    void sendStack(uint8_t command, uint8_t argHigh, uint8_t argLow); // Queue command with two 8-bit parameters
+    void processQueue();             // Retransmit on ACK timeout or send the next queued frame when the line is free
+    void dequeueCommand();           // Remove the command in flight from the queue
+    bool resolveQuery(uint8_t command, int value); // Hand a response to the oldest matching query, false if none
+    void expireQueries();            // Report -1 to queries that did not get a response within the timeout
 
     // Internal utilities for frame handling
     void enableACK();                // Turn on ACK request in outgoing commands
@@ -192,10 +307,15 @@ private:
 
     void parseStack();               // Interpret a fully received frame in _received buffer
     bool validateStack();            // Validate checksum (and any other needed checks) for received frame
+    void rejectFrame(uint8_t length); // Report a broken frame of length bytes and resync at the next start byte
 
-    // Handle an incoming message or error, setting internal state
-    bool handleMessage(uint8_t type, uint16_t parameter = 0);
+    // Handle an incoming message or error by queueing it as event
+    bool handleMessage(uint8_t type, uint16_t parameter = 0, uint8_t command = 0);
     bool handleError(uint8_t type, uint16_t parameter = 0);
+
+    void removeEvent(uint8_t position); // Take the event at position (counted from the head) out of the queue
+    int readQuery(uint8_t command, uint16_t argument = 0); // Send a query and wait for its response (read*() methods)
+    int waitFeedBack(uint8_t command); // Wait for the response to command, -1 on timeout
 };
 
 #endif  // DFRobotDFPlayerMini_h
@@ -0,0 +1,69 @@
+#include "FileDurations.h"
+#include <EEPROM.h>
+
+// --- Slot layout ---
+// [generation << 4 | folder][file][duration in FILE_DURATION_UNIT_MS]. A slot is only valid in the
+// generation it was written in, so clearing the table is a single write to the generation byte.
+// An erased EEPROM (0xFF) reads as generation 0 and as an empty slot.
+const uint8_t MAX_FOLDER = 0x0F;
+const uint8_t MAX_GENERATION = 14;   // generation 15 with folder 15 would be an erased slot
+const uint8_t MAX_UNITS = 254;
+
+// --- Internal Utility ---
+static int slotAddress(uint8_t folder, uint8_t file) {
+  uint8_t slot = (uint8_t)(file * 7 + folder) % FILE_DURATION_SLOTS;
+  return FILE_DURATION_EEPROM_ADDRESS + slot * 3;
+}
+
+static uint8_t currentGeneration() {
+  uint8_t generation = EEPROM.read(FILE_DURATION_GENERATION_ADDRESS);
+  return generation > MAX_GENERATION ? 0 : generation;
+}
+
+static uint8_t slotTag(uint8_t folder) {
+  return (uint8_t)(currentGeneration() << 4) | folder;
+}
+
+// --- Implementation ---
+uint16_t getFileDuration(uint8_t folder, uint8_t file) {
+  int address = slotAddress(folder, file);
+  if (folder > MAX_FOLDER || EEPROM.read(address) != slotTag(folder) || EEPROM.read(address + 1) != file) {
+    return 0;
+  }
+  return (uint16_t)EEPROM.read(address + 2) * FILE_DURATION_UNIT_MS;
+}
+
+void learnFileDuration(uint8_t folder, uint8_t file, uint16_t durationMs) {
+  // round up, a timeout derived from it must never be too short
+  uint16_t units = (durationMs + FILE_DURATION_UNIT_MS - 1) / FILE_DURATION_UNIT_MS;
+  if (folder > MAX_FOLDER || units == 0 || units > MAX_UNITS) {
+    return;
+  }
+
+  // the measured time of a file jitters by a few ms (tick, serial line): a change of one unit is
+  // not worth an EEPROM cycle, the sound timeout has a margin of several units anyway
+  int address = slotAddress(folder, file);
+  uint8_t tag = slotTag(folder);
+  if (EEPROM.read(address) == tag && EEPROM.read(address + 1) == file) {
+    uint8_t stored = EEPROM.read(address + 2);
+    if (units <= stored + 1 && stored <= units + 1) {
+      return;
+    }
+  }
+
+  EEPROM.update(address, tag);
+  EEPROM.update(address + 1, file);
+  EEPROM.update(address + 2, (uint8_t)units);
+}
+
+void clearFileDurations() {
+  uint8_t generation = currentGeneration() + 1;
+  if (generation > MAX_GENERATION) {
+    // the generations start over: slots of an old generation 0 would be valid again
+    for (uint8_t slot = 0; slot < FILE_DURATION_SLOTS; slot++) {
+      EEPROM.update(FILE_DURATION_EEPROM_ADDRESS + slot * 3, 0xFF);
+    }
+    generation = 0;
+  }
+  EEPROM.update(FILE_DURATION_GENERATION_ADDRESS, generation);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Arduino.h"
+
+// Learned playback duration per (folder, file), measured from playFolder() to "play finished".
+// The table lives in the EEPROM behind the SD card catalog (see SdCatalogCache.h), so it costs
+// no RAM and survives a reboot. It is direct mapped: a file can evict another one with the same slot.
+
+#define FILE_DURATION_EEPROM_ADDRESS 64   // start of the table in EEPROM
+#define FILE_DURATION_GENERATION_ADDRESS 63  // the byte before the table, behind the SD card catalog
+#define FILE_DURATION_SLOTS 128           // 3 bytes each
+#define FILE_DURATION_UNIT_MS 50          // resolution, longest storable duration is 254 units (12.7s)
+
+// Returns the learned duration in ms, 0 if unknown
+uint16_t getFileDuration(uint8_t folder, uint8_t file);
+
+// Stores a measured duration. Durations too long to store, folders above 15 and changes of a single
+// unit are ignored.
+void learnFileDuration(uint8_t folder, uint8_t file, uint16_t durationMs);
+
+// Forget all durations (e.g. a different SD card was inserted). Starts a new generation of the table,
+// one EEPROM write; every 15th call erases the slots.
+void clearFileDurations();
@@ -0,0 +1,86 @@
+#pragma once
+
+// Generated by tools/flapTables.py from the WAV files in resources. Do not edit, run the tool
+// again when the sounds change. Durations in FLAP_TICK_MS, the first flap starts 240 ms
+// after the sound.
+
+#include "Arduino.h"
+#include "BirdFlapGenerator.h"
+
+static_assert(FLAP_TICK_MS == 10, "FlapTables.h was generated for another tick, run tools/flapTables.py");
+
+// 01/001.wav, 1202 ms
+static const uint8_t flaps_01_001[] PROGMEM = {
+  7, 10
+};
+static const uint8_t breaks_01_001[] PROGMEM = {
+  20, 42, 17
+};
+
+// 04/001.wav, 1601 ms
+static const uint8_t flaps_04_001[] PROGMEM = {
+  5, 5, 5, 11, 14, 5, 5, 7
+};
+static const uint8_t breaks_04_001[] PROGMEM = {
+  8, 8, 8, 8, 8, 8, 8, 23
+};
+
+// 04/002.wav, 3958 ms
+static const uint8_t flaps_04_002[] PROGMEM = {
+  10, 6, 10, 11, 6, 13, 5, 5, 6, 5, 7, 6, 5, 9
+};
+static const uint8_t breaks_04_002[] PROGMEM = {
+  80, 8, 8, 8, 25, 8, 8, 8, 36, 12, 8, 8, 17, 8, 26
+};
+
+// 04/003.wav, 4471 ms
+static const uint8_t flaps_04_003[] PROGMEM = {
+  13, 5, 17, 11, 5, 6, 9, 13, 5, 7, 5, 5, 13, 5, 11, 9
+};
+static const uint8_t breaks_04_003[] PROGMEM = {
+  59, 8, 10, 8, 8, 19, 8, 89, 8, 8, 8, 9, 8, 8, 8, 8, 10
+};
+
+// 04/004.wav, 2666 ms
+static const uint8_t flaps_04_004[] PROGMEM = {
+  17, 11, 16, 5, 10, 17, 5
+};
+static const uint8_t breaks_04_004[] PROGMEM = {
+  63, 8, 42, 8, 8, 15, 8, 10
+};
+
+// 04/005.wav, 1637 ms
+static const uint8_t flaps_04_005[] PROGMEM = {
+  14, 5, 6, 11, 8
+};
+static const uint8_t breaks_04_005[] PROGMEM = {
+  35, 8, 8, 8, 21, 16
+};
+
+// 04/006.wav, 1627 ms
+static const uint8_t flaps_04_006[] PROGMEM = {
+  9, 8, 7, 17, 5
+};
+static const uint8_t breaks_04_006[] PROGMEM = {
+  30, 14, 17, 16, 8, 8
+};
+
+// 04/007.wav, 3910 ms
+static const uint8_t flaps_04_007[] PROGMEM = {
+  6, 5, 10, 11, 17, 8, 10, 8, 15, 5, 5, 5, 5, 8
+};
+static const uint8_t breaks_04_007[] PROGMEM = {
+  59, 8, 8, 15, 46, 8, 8, 8, 8, 8, 9, 14, 8, 8, 34
+};
+
+static const FlapTable flapTables[] PROGMEM = {
+  // folder file duration  flaps  breaks  flapCount  breakCount
+  {1, 1, 1202, flaps_01_001, breaks_01_001, 2, 3},
+  {4, 1, 1601, flaps_04_001, breaks_04_001, 8, 8},
+  {4, 2, 3958, flaps_04_002, breaks_04_002, 14, 15},
+  {4, 3, 4471, flaps_04_003, breaks_04_003, 16, 17},
+  {4, 4, 2666, flaps_04_004, breaks_04_004, 7, 8},
+  {4, 5, 1637, flaps_04_005, breaks_04_005, 5, 6},
+  {4, 6, 1627, flaps_04_006, breaks_04_006, 5, 6},
+  {4, 7, 3910, flaps_04_007, breaks_04_007, 14, 15},
+};
@@ -0,0 +1,77 @@
+#include "IdleSleep.h"
+
+#if defined(__AVR__)
+#include <avr/sleep.h>
+#endif
+
+// --- State ---
+static uint8_t wakePins[IDLE_WAKE_PINS];
+static uint8_t wakePinCount = 0;
+
+static uint32_t statisticsStart = 0;
+static uint32_t sleptMs = 0;
+static uint32_t sleptUsRemainder = 0;
+
+// --- Internal Utility ---
+// pin levels as bit mask
+static uint8_t readWakePins() {
+  uint8_t levels = 0;
+  for (uint8_t i = 0; i < wakePinCount; i++) {
+    if (digitalRead(wakePins[i])) {
+      levels |= 1 << i;
+    }
+  }
+  return levels;
+}
+
+// until the next interrupt
+static void idleWait() {
+#if defined(__AVR__)
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  sleep_mode();
+#else
+  yield();
+#endif
+}
+
+// --- Implementation ---
+void watchIdleWakePin(uint8_t pin) {
+  if (wakePinCount < IDLE_WAKE_PINS) {
+    wakePins[wakePinCount++] = pin;
+  }
+}
+
+bool sleepUntil(uint32_t wakeTime) {
+  uint32_t start = micros();
+  uint8_t levels = readWakePins();
+  bool woken = false;
+
+  while ((int32_t)(millis() - wakeTime) < 0) {
+    idleWait();
+    if (readWakePins() != levels) {
+      woken = true;
+      break;
+    }
+  }
+
+  // micros() of a single sleep never overflows, the sum is kept in ms
+  sleptUsRemainder += micros() - start;
+  sleptMs += sleptUsRemainder / 1000;
+  sleptUsRemainder %= 1000;
+  return woken;
+}
+
+uint8_t idlePercent() {
+  uint32_t elapsed = millis() - statisticsStart;
+  if (elapsed < 100) {
+    return 0;
+  }
+  uint32_t percent = sleptMs / (elapsed / 100);
+  return percent > 100 ? 100 : percent;
+}
+
+void resetIdleStatistics() {
+  statisticsStart = millis();
+  sleptMs = 0;
+  sleptUsRemainder = 0;
+}
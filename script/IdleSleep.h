@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Arduino.h"
+
+// Sleeps between loop ticks instead of busy waiting. The CPU halts in SLEEP_MODE_IDLE: the timers keep
+// running, so millis() and all JobManager deadlines stay correct, and every interrupt wakes it up
+// (Timer0 about every millisecond, serial bytes). After each wake up the watched pins are compared,
+// so a sensor change ends the sleep within a millisecond.
+// Deeper sleep modes would stop Timer0 (millis) and SoftwareSerial reception and are not used.
+// On other targets (host builds with a virtual clock) the wait calls yield() instead.
+
+const uint8_t IDLE_WAKE_PINS = 4;
+
+// --- API ---
+void watchIdleWakePin(uint8_t pin);          // a change of this digital pin ends the sleep
+bool sleepUntil(uint32_t wakeTime);          // returns true if a watched pin woke it up before wakeTime
+uint8_t idlePercent();                       // share of the time spent asleep since the last reset
+void resetIdleStatistics();
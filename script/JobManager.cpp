@@ -1,10 +1,37 @@
-#include <SoftTimers.h>
+#include <Arduino.h>
 
+// A job is either running, in backoff or idle. Running and backoff each end at a deadline.
+// Jobs with a pending deadline are kept in one list sorted by deadline, so handleDueJobs()
+// only touches the jobs that actually expired and nextDeadline() tells when the next one is due.
 class JobManager {
 private:
-  // SoftTimer for job duration and backoff timer
-  SoftTimer jobTimer;
-  SoftTimer backoffTimer;
+  // Start of the job or backoff period, the deadline is timerStart + the duration of the period
+  uint32_t timerStart = 0;
+  uint32_t deadline = 0;
+
+  // Sorted list of the scheduled jobs (earliest deadline first). A function local static, because this
+  // file is compiled on its own and included by the sketch as well
+  static JobManager*& firstDue() {
+    static JobManager* first = nullptr;
+    return first;
+  }
+  JobManager* nextDue = nullptr;
+  bool isScheduled = false;
+
+  // Optional observer of job starts and ends (e.g. the timeline, see Timeline.h)
+  typedef void (*JobHook)(JobManager& job, bool started);
+  static JobHook& jobHook() {
+    static JobHook hook = nullptr;
+    return hook;
+  }
+
+  // Optional observer of the time spent in the enable and disable functions (e.g. the loop profiler,
+  // see LoopProfiler.h). Includes the jobs they start or end themselves.
+  typedef void (*JobCostHook)(JobManager& job, uint32_t durationUs);
+  static JobCostHook& jobCostHook() {
+    static JobCostHook hook = nullptr;
+    return hook;
+  }
 
   // Pointers to enable and disable functions
   void (*enableFunction)();
@@ -31,21 +58,19 @@ public:
     void (*disableFn)(), 
     bool runOnceMode = false,
     bool startInBackoffMode = false
-  ) : jobDuration(jobDurationMillis), 
-      backoffDuration(backoffDurationMillis), 
-      enableFunction(enableFn), 
+  ) : enableFunction(enableFn), 
       disableFunction(disableFn), 
+      jobDuration(jobDurationMillis), 
+      backoffDuration(backoffDurationMillis), 
       runOnceModeActive(runOnceMode) {
     
-    jobTimer.setTimeOutTime(jobDuration);  // Set the job duration timeout
-    backoffTimer.setTimeOutTime(backoffDuration);  // Set the backoff duration timeout
     if(startInBackoffMode){
       if(runOnceMode) {
         //this enables the run once mode to start in the hasRun state
         hasRunOnce = true;
       }
-      backoffTimer.reset();
       isInBackoff = true;
+      startTimer(backoffDuration);
     }
   }
 
@@ -55,14 +80,11 @@ public:
     void (*enableFn)(), 
     void (*disableFn)(), 
     bool runOnceMode = false
-  ) : jobDuration(jobDurationMillis), 
-      backoffDuration(0), 
-      enableFunction(enableFn), 
+  ) : enableFunction(enableFn), 
       disableFunction(disableFn), 
+      jobDuration(jobDurationMillis), 
+      backoffDuration(0), 
       runOnceModeActive(runOnceMode){
-    
-    jobTimer.setTimeOutTime(jobDuration);  // Set the job duration timeout
-    backoffTimer.setTimeOutTime(backoffDuration);  // Set the backoff duration timeout
   }
 
   // Function to start the job if it's not running, not in backoff, and allowed by runOnce mode
@@ -71,9 +93,17 @@ public:
       isJobRunning = true;
       hasRunOnce = true;  // Mark that the job has run once if in "run once" mode
 
-      enableFunction();  // Call the enable function when starting the job
+      // Start the timer first: the enable function may change the duration or restart the timer
+      startTimer(jobDuration);
 
-      jobTimer.reset();  // Reset the job timer for the job duration
+      if (jobHook()) {
+        jobHook()(*this, true);
+      }
+      uint32_t start = jobCostHook() ? micros() : 0;
+      enableFunction();  // Call the enable function when starting the job
+      if (jobCostHook()) {
+        jobCostHook()(*this, micros() - start);
+      }
     }
   }
   
@@ -87,63 +117,96 @@ public:
   // Function to restart the job timer (can only restart the timer while the job is running)
   void restartJobTimer() {
     if (isJobRunning && !isInBackoff) {
-      jobTimer.reset();
+      startTimer(jobDuration);
     }
   }
 
   // Function to reset the backoff timer
   void renewBackoff() {
-    if(isInBackoff && !backoffTimer.hasTimedOut()) {
-      backoffTimer.reset();  // Reset the backoff timer
+    if(isInBackoff && !hasPassed(millis())) {
+      startTimer(backoffDuration);  // Reset the backoff timer
     }
 
   }
 
   void endJob() {
     if(isJobRunning) {
+      if (jobHook()) {
+        jobHook()(*this, false);
+      }
       if (disableFunction) {
+        uint32_t start = jobCostHook() ? micros() : 0;
         disableFunction();  // Call the disable function when stopping the job
+        if (jobCostHook()) {
+          jobCostHook()(*this, micros() - start);
+        }
       }
       isJobRunning = false;
     }
 
     if(backoffDuration != 0) {
         isInBackoff = true;  // Enter backoff state
-        backoffTimer.reset();  // Reset the backoff timer
+        startTimer(backoffDuration);  // Reset the backoff timer
+      } else if (!isInBackoff) {
+        unschedule();
       }
 
   }
 
-  // Function to check and handle the job and backoff in loop()
-  void handleJob() {
-    // Check if the job has timed out
-    if (isJobRunning && jobTimer.hasTimedOut()) {
-      endJob();
+  // Call this in loop(): ends the jobs and backoff periods whose deadline has passed.
+  // Reads millis() once and only visits expired jobs.
+  static void handleDueJobs() {
+    uint32_t now = millis();
+    // the callbacks can schedule other jobs, so always take the current head of the list
+    while (firstDue() && firstDue()->hasPassed(now)) {
+      JobManager* job = firstDue();
+      job->unschedule();
+      job->expire();
     }
+  }
 
-    // Check if backoff has ended
-    if (isInBackoff && backoffTimer.hasTimedOut()) {
-      isInBackoff = false;  // End the backoff period, allowing the job to start again
+  // Calls hook with started = true right before the enable function, with false right before the
+  // disable function of every job
+  static void setJobHook(JobHook hook) {
+    jobHook() = hook;
+  }
+
+  // Calls hook with the execution time of the enable function and of the disable function of every job
+  static void setJobCostHook(JobCostHook hook) {
+    jobCostHook() = hook;
+  }
+
+  // Time of the next deadline of any job. Returns false if no job is scheduled.
+  static bool nextDeadline(uint32_t& when) {
+    if (!firstDue()) {
+      return false;
     }
+    when = firstDue()->deadline + 1;  // a period has passed when more than its duration elapsed
+    return true;
   }
 
   // Utility functions to get remaining job or backoff time
   uint16_t getRemainingJobTime() {
-    return jobTimer.getRemainingTime();
+    return isJobRunning ? remainingTime() : 0;
   }
 
   uint16_t getRemainingBackoffTime() {
-    return backoffTimer.getRemainingTime();
+    return (isInBackoff && !isJobRunning) ? remainingTime() : 0;
   }
 
+  // A running job keeps its start time and ends after the new duration
   void setNewDurationTime(uint16_t newDuration){
     jobDuration = newDuration;
-    jobTimer.setTimeOutTime(jobDuration);
+    if (isJobRunning) {
+      schedule(timerStart + jobDuration);
+    }
   }
 
   void setNewBackoffTime(uint16_t newBackoffDuration){
     backoffDuration = newBackoffDuration;
-    backoffTimer.setTimeOutTime(backoffDuration);
+    if (isInBackoff && !isJobRunning) {
+      schedule(timerStart + backoffDuration);
+    }
   }
 
   uint16_t getJobDuration(){
@@ -163,4 +226,54 @@ public:
   bool isBackoffActive() {
     return isInBackoff;
   }
+
+private:
+  void startTimer(uint16_t duration) {
+    timerStart = millis();
+    schedule(timerStart + duration);
+  }
+
+  bool hasPassed(uint32_t now) const {
+    return (int32_t)(now - deadline) > 0;
+  }
+
+  uint16_t remainingTime() const {
+    int32_t remaining = (int32_t)(deadline - millis());
+    return remaining > 0 ? remaining : 0;
+  }
+
+  // Deadline of the running job or the backoff period has passed
+  void expire() {
+    if (isJobRunning) {
+      endJob();
+    } else if (isInBackoff) {
+      isInBackoff = false;  // End the backoff period, allowing the job to start again
+    }
+  }
+
+  // (Re)insert the job into the sorted list
+  void schedule(uint32_t when) {
+    unschedule();
+    deadline = when;
+    JobManager** link = &firstDue();
+    while (*link && (int32_t)((*link)->deadline - when) <= 0) {
+      link = &(*link)->nextDue;
+    }
+    nextDue = *link;
+    *link = this;
+    isScheduled = true;
+  }
+
+  void unschedule() {
+    if (!isScheduled) {
+      return;
+    }
+    JobManager** link = &firstDue();
+    while (*link != this) {
+      link = &(*link)->nextDue;
+    }
+    *link = nextDue;
+    nextDue = nullptr;
+    isScheduled = false;
+  }
 };
@@ -0,0 +1,61 @@
+#include "Log.h"
+
+// --- Ring ---
+// about 150 bytes of RAM. Without LOG_LEVEL nothing references them and the linker drops them.
+struct LogEntry {
+  uint8_t event;
+  uint32_t time;
+  int16_t a;
+  int16_t b;
+};
+
+const uint8_t RECORD_LENGTH = 10;   // on serial, with the sync byte
+
+static LogEntry ring[LOG_RING_SIZE];
+static uint8_t head = 0;
+static uint8_t tail = 0;
+static uint16_t lost = 0;
+
+// --- Internal Utility ---
+static void writeValue(Stream& output, uint32_t value, uint8_t bytes) {
+  for (uint8_t i = 0; i < bytes; i++) {
+    output.write((uint8_t)(value >> (8 * i)));
+  }
+}
+
+static void writeEntry(Stream& output, const LogEntry& entry) {
+  output.write(LOG_SYNC);
+  output.write(entry.event);
+  writeValue(output, entry.time, 4);
+  writeValue(output, (uint16_t)entry.a, 2);
+  writeValue(output, (uint16_t)entry.b, 2);
+}
+
+// --- Implementation ---
+void logRecord(uint8_t event, int16_t a, int16_t b) {
+  uint8_t next = (head + 1) & (LOG_RING_SIZE - 1);
+  if (next == tail) {
+    if (lost < 0xFFFF) {
+      lost++;
+    }
+    return;
+  }
+  ring[head].event = event;
+  ring[head].time = millis();
+  ring[head].a = a;
+  ring[head].b = b;
+  head = next;
+}
+
+void flushLog(Stream& output) {
+  while (tail != head && output.availableForWrite() >= RECORD_LENGTH) {
+    writeEntry(output, ring[tail]);
+    tail = (tail + 1) & (LOG_RING_SIZE - 1);
+  }
+  // the lost records came after the ones in the ring
+  if (lost > 0 && tail == head && output.availableForWrite() >= RECORD_LENGTH) {
+    LogEntry entry = {LOG_LOST, (uint32_t)millis(), (int16_t)lost, 0};
+    writeEntry(output, entry);
+    lost = 0;
+  }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Arduino.h"
+
+// Binary logging. Define LOG_LEVEL before including this header to enable it:
+//   1 errors, 2 what the unit does, 3 details
+// Log calls above the level (all of them without LOG_LEVEL) compile to nothing, their arguments are
+// not even evaluated. An enabled call only stores a fixed size record (event id, millis(), two
+// values) in a RAM ring; flushLog() writes the records to serial while the unit waits for the next
+// tick. The texts are in LogEvents.h only, tools/logDecode.py turns the records back into text.
+
+// --- Events ---
+enum LogEvent : uint8_t {
+#define LOG_EVENT(id, text) id,
+#include "LogEvents.h"
+#undef LOG_EVENT
+  LOG_EVENTS
+};
+
+const uint8_t LOG_RING_SIZE = 16;   // records (9 bytes each), power of two
+const uint8_t LOG_SYNC = 0xA5;      // first byte of a record on serial, followed by id, time, a, b (little endian)
+
+// --- API ---
+void logRecord(uint8_t event, int16_t a = 0, int16_t b = 0);
+
+// Writes as many records as output takes without waiting
+void flushLog(Stream& output);
+
+// --- Macros ---
+#if defined(LOG_LEVEL) && LOG_LEVEL >= 1
+  #define LOG_ERROR(...) logRecord(__VA_ARGS__)
+  #define LOG_FLUSH(output) flushLog(output)
+#else
+  #define LOG_ERROR(...)
+  #define LOG_FLUSH(output)
+#endif
+
+#if defined(LOG_LEVEL) && LOG_LEVEL >= 2
+  #define LOG_INFO(...) logRecord(__VA_ARGS__)
+#else
+  #define LOG_INFO(...)
+#endif
+
+#if defined(LOG_LEVEL) && LOG_LEVEL >= 3
+  #define LOG_DEBUG(...) logRecord(__VA_ARGS__)
+#else
+  #define LOG_DEBUG(...)
+#endif
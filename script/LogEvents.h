@@ -0,0 +1,52 @@
+// Log events: id and text. No include guard, this list is included by Log.h with different
+// definitions of LOG_EVENT. The texts are never compiled into the firmware: tools/logDecode.py reads
+// them from this file, %d are replaced by the two values of the record. Only append new events at the
+// end, the ids of a running unit must match the file the decoder reads.
+
+LOG_EVENT(LOG_LOST, "%d log records lost (ring full)")
+
+// --- Jobs ---
+LOG_EVENT(LOG_SOAP_ON, "soap on (sound job active: %d)")
+LOG_EVENT(LOG_SOAP_OFF, "soap off")
+LOG_EVENT(LOG_ROOM_ON, "room on")
+LOG_EVENT(LOG_SHAKE_ON, "shake on")
+LOG_EVENT(LOG_SOUND_ON, "sound on, folder %d")
+LOG_EVENT(LOG_FOLDER_NOT_SCANNED, "folder %d not scanned yet, no sound")
+LOG_EVENT(LOG_PLAY_FILE, "playing file %d from folder %d")
+LOG_EVENT(LOG_LEARNED_DURATION, "learned duration %d ms")
+LOG_EVENT(LOG_BIRD_OUT, "bird goes out")
+LOG_EVENT(LOG_PLAY_FINISHED, "play finished, file %d")
+
+// --- DFPlayer ---
+LOG_EVENT(LOG_DFPLAYER_TIMEOUT, "DFPlayer: time out")
+LOG_EVENT(LOG_DFPLAYER_WRONG_STACK, "DFPlayer: wrong stack")
+LOG_EVENT(LOG_DFPLAYER_CARD_INSERTED, "DFPlayer: card inserted")
+LOG_EVENT(LOG_DFPLAYER_CARD_REMOVED, "DFPlayer: card removed")
+LOG_EVENT(LOG_DFPLAYER_CARD_ONLINE, "DFPlayer: card online")
+LOG_EVENT(LOG_DFPLAYER_USB_INSERTED, "DFPlayer: USB inserted")
+LOG_EVENT(LOG_DFPLAYER_USB_REMOVED, "DFPlayer: USB removed")
+LOG_EVENT(LOG_DFPLAYER_NUMBER_FINISHED, "DFPlayer: number %d play finished")
+LOG_EVENT(LOG_DFPLAYER_ERROR, "DFPlayer: error %d (1 busy/card not found, 2 sleeping, 3 wrong stack, 4 checksum, 5 file index out of bound, 6 file not found, 7 in advertise)")
+LOG_EVENT(LOG_DFPLAYER_REINIT, "reinitializing the DFPlayer after long uptime and inactivity")
+LOG_EVENT(LOG_DFPLAYER_REINIT_DONE, "DFPlayer reinitialized (ok: %d)")
+
+// --- SD card scan ---
+LOG_EVENT(LOG_SCAN_STARTED, "SD card scan started")
+LOG_EVENT(LOG_SCAN_READ, "scan read %d")
+LOG_EVENT(LOG_SCAN_TOTAL_FILES, "total files on the SD card: %d")
+LOG_EVENT(LOG_SCAN_CATALOG_LOADED, "catalog loaded from EEPROM, folders: %d")
+LOG_EVENT(LOG_SCAN_NO_FOLDER_COUNT, "folder count not supported or wrong, falling back to file detection")
+LOG_EVENT(LOG_SCAN_FOLDERS, "folders after reading the folder count: %d")
+LOG_EVENT(LOG_SCAN_FOLDER_FILES, "folder %d: %d files")
+LOG_EVENT(LOG_SCAN_EMPTY_FOLDER, "found a folder with 0 or -1 files, stopping")
+LOG_EVENT(LOG_SCAN_FILE_DETECTION, "file detection is active")
+LOG_EVENT(LOG_SCAN_DETECTED_FOLDERS, "files in the first %d folders")
+LOG_EVENT(LOG_SCAN_FINISHED, "SD card scan finished")
+
+// --- Sensors and buttons ---
+LOG_EVENT(LOG_SHAKE_INCIDENT, "shake incident, peak energy %d, shakes in the window %d")
+LOG_EVENT(LOG_ROOM_FOLDER, "sounds will be played from room folder %d (folders: %d)")
+LOG_EVENT(LOG_MANUAL_SOAP, "manual soap %d (1 on, 0 off)")
+
+// --- SD card scan ---
+LOG_EVENT(LOG_SCAN_PROGRESS, "SD card scan %d percent done")
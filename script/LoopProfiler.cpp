@@ -0,0 +1,110 @@
+#include "LoopProfiler.h"
+
+// --- Statistics ---
+// about 250 bytes of RAM. Without LOOP_PROFILER nothing references them and the linker drops them.
+static uint16_t histogram[PROFILE_SECTIONS][PROFILE_BUCKETS];
+static uint32_t worstCase[PROFILE_SECTIONS];
+static uint16_t jobCalls[PROFILE_JOB_COUNT];
+static uint32_t jobTotal[PROFILE_JOB_COUNT];
+static uint32_t jobWorstCase[PROFILE_JOB_COUNT];
+static uint32_t lastTickStart = 0;
+static bool hasLastTick = false;
+
+// --- Internal Utility ---
+static uint8_t bucketOf(uint32_t durationUs) {
+  uint8_t bucket = 0;
+  durationUs >>= 7;
+  while (durationUs && bucket < PROFILE_BUCKETS - 1) {
+    durationUs >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+static void printSectionName(uint8_t section) {
+  switch (section) {
+    case PROFILE_PERIOD:       Serial.print(F("period      ")); break;
+    case PROFILE_TICK:         Serial.print(F("tick        ")); break;
+    case PROFILE_JOBS:         Serial.print(F("jobs        ")); break;
+    case PROFILE_CHOREOGRAPHY: Serial.print(F("choreography")); break;
+    case PROFILE_DFPLAYER:     Serial.print(F("dfplayer    ")); break;
+    case PROFILE_SD_SCAN:      Serial.print(F("sd scan     ")); break;
+    case PROFILE_BUTTONS:      Serial.print(F("buttons     ")); break;
+    case PROFILE_SOUND_ON:     Serial.print(F("sound on    ")); break;
+  }
+}
+
+static void printJobName(uint8_t job) {
+  switch (job) {
+    case PROFILE_JOB_SOUND: Serial.print(F("sound       ")); break;
+    case PROFILE_JOB_SOAP:  Serial.print(F("soap        ")); break;
+    case PROFILE_JOB_ROOM:  Serial.print(F("room        ")); break;
+    case PROFILE_JOB_SHAKE: Serial.print(F("shake       ")); break;
+    case PROFILE_JOB_LED:   Serial.print(F("led         ")); break;
+  }
+}
+
+// --- Implementation ---
+void profileRecord(uint8_t section, uint32_t durationUs) {
+  uint16_t& count = histogram[section][bucketOf(durationUs)];
+  if (count < 0xFFFF) {
+    count++;  // saturate instead of wrapping on long running units
+  }
+  if (durationUs > worstCase[section]) {
+    worstCase[section] = durationUs;
+  }
+}
+
+void profileJob(uint8_t job, uint32_t durationUs) {
+  if (jobCalls[job] < 0xFFFF) {
+    jobCalls[job]++;
+    jobTotal[job] += durationUs;  // stops with the count, the average stays right
+  }
+  if (durationUs > jobWorstCase[job]) {
+    jobWorstCase[job] = durationUs;
+  }
+}
+
+void profileTick() {
+  uint32_t now = micros();
+  if (hasLastTick) {
+    profileRecord(PROFILE_PERIOD, now - lastTickStart);
+  }
+  lastTickStart = now;
+  hasLastTick = true;
+}
+
+void profileDump() {
+  Serial.println(F("section      max us  | <128us <256 <512 <1ms <2ms <4ms <8ms <16ms <32ms >32ms"));
+  for (uint8_t section = 0; section < PROFILE_SECTIONS; section++) {
+    printSectionName(section);
+    Serial.print(' ');
+    Serial.print(worstCase[section]);
+    Serial.print(F(" |"));
+    for (uint8_t bucket = 0; bucket < PROFILE_BUCKETS; bucket++) {
+      Serial.print(' ');
+      Serial.print(histogram[section][bucket]);
+    }
+    Serial.println();
+  }
+
+  Serial.println(F("job          calls | total us | max us"));
+  for (uint8_t job = 0; job < PROFILE_JOB_COUNT; job++) {
+    printJobName(job);
+    Serial.print(' ');
+    Serial.print(jobCalls[job]);
+    Serial.print(F(" | "));
+    Serial.print(jobTotal[job]);
+    Serial.print(F(" | "));
+    Serial.println(jobWorstCase[job]);
+  }
+}
+
+void profileReset() {
+  memset(histogram, 0, sizeof(histogram));
+  memset(worstCase, 0, sizeof(worstCase));
+  memset(jobCalls, 0, sizeof(jobCalls));
+  memset(jobTotal, 0, sizeof(jobTotal));
+  memset(jobWorstCase, 0, sizeof(jobWorstCase));
+  hasLastTick = false;  // the dump itself would show up as a long period
+}
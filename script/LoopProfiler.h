@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Arduino.h"
+
+// Loop timing profiler based on micros(). Define LOOP_PROFILER before including this header to
+// enable it; otherwise the PROFILE_* macros are empty and nothing is compiled in.
+// Every section keeps a histogram of its durations (power of two buckets) and its worst case,
+// every job the count, total and worst case of its enable and disable functions.
+// Send 'p' over the serial monitor to print and reset the statistics.
+
+// --- Sections ---
+enum ProfileSection : uint8_t {
+  PROFILE_PERIOD,         // start of one tick to the start of the next (MAIN_LOOP_TIME_BASE_MS, longer when idle)
+  PROFILE_TICK,           // execution time of one tick
+  PROFILE_JOBS,           // due jobs and their callbacks
+  PROFILE_CHOREOGRAPHY,
+  PROFILE_DFPLAYER,       // DFPlayer events
+  PROFILE_SD_SCAN,
+  PROFILE_BUTTONS,        // button handling including the beep menu
+  PROFILE_SOUND_ON,       // soundOn() callback (play command, duration lookup, flap pattern)
+  PROFILE_SECTIONS
+};
+
+// --- Jobs ---
+enum ProfileJob : uint8_t {
+  PROFILE_JOB_SOUND,
+  PROFILE_JOB_SOAP,
+  PROFILE_JOB_ROOM,
+  PROFILE_JOB_SHAKE,
+  PROFILE_JOB_LED,        // both LED blinking jobs
+  PROFILE_JOB_COUNT
+};
+
+// Bucket i counts durations below 128us << i, the last bucket everything above
+const uint8_t PROFILE_BUCKETS = 10;
+
+// --- API ---
+void profileRecord(uint8_t section, uint32_t durationUs);
+void profileJob(uint8_t job, uint32_t durationUs);  // one enable or disable function of a job
+void profileTick();       // Call at the start of every tick, records PROFILE_PERIOD
+void profileDump();       // Prints all histograms to Serial
+void profileReset();
+
+class ProfileScope {
+public:
+  ProfileScope(uint8_t section) : section(section), start(micros()) {}
+  ~ProfileScope() { profileRecord(section, micros() - start); }
+private:
+  uint8_t section;
+  uint32_t start;
+};
+
+// --- Macros ---
+#ifdef LOOP_PROFILER
+  #define PROFILE_TICK() profileTick()
+  #define PROFILE_SCOPE(section) ProfileScope profileScope_##section(section)
+  #define PROFILE_BEGIN(section) uint32_t profileStart_##section = micros()
+  #define PROFILE_END(section) profileRecord(section, micros() - profileStart_##section)
+#else
+  #define PROFILE_TICK()
+  #define PROFILE_SCOPE(section)
+  #define PROFILE_BEGIN(section)
+  #define PROFILE_END(section)
+#endif
@@ -0,0 +1,72 @@
+#include "Random.h"
+#include <EEPROM.h>
+
+// --- Constants ---
+const uint8_t FLOATING_PIN_READS = 16;
+const uint8_t NEXT_BOOT_STREAM = 0xFF;     // seed stored for the next boot
+
+// --- Pool State ---
+static uint32_t pool = 0;
+static uint16_t ticksLeft = ENTROPY_TICKS;
+static uint8_t poolGeneration = 1;         // streams start at 0, so they are seeded on first use
+
+// --- Internal Utility ---
+// rotate and xor: every bit of the pool keeps its entropy
+static void mix(uint16_t value) {
+  pool = (pool << 7 | pool >> 25) ^ value;
+}
+
+// independent seed per stream (murmur3 finalizer), never 0
+static uint32_t seedFor(uint8_t streamId) {
+  uint32_t h = pool ^ ((uint32_t)streamId * 0x9E3779B9UL);
+  h ^= h >> 16;
+  h *= 0x85EBCA6BUL;
+  h ^= h >> 13;
+  h *= 0xC2B2AE35UL;
+  h ^= h >> 16;
+  return h ? h : 1;
+}
+
+static void reseedStreams() {
+  poolGeneration++;
+  EEPROM.put(RANDOM_SEED_EEPROM_ADDRESS, seedFor(NEXT_BOOT_STREAM));  // put() only writes changed bytes
+}
+
+// --- Streams ---
+uint16_t RandomStream::next() {
+  if (generation != poolGeneration) {
+    state = seedFor(id);
+    generation = poolGeneration;
+  }
+  // xorshift32 (13, 17, 5)
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state >> 16;
+}
+
+uint16_t RandomStream::between(uint16_t minVal, uint16_t maxVal) {
+  uint32_t range = (uint32_t)maxVal - minVal + 1;
+  return minVal + (uint16_t)((next() * range) >> 16);
+}
+
+// --- Entropy Pool ---
+void beginEntropy(uint8_t floatingPin) {
+  EEPROM.get(RANDOM_SEED_EEPROM_ADDRESS, pool);
+  for (uint8_t i = 0; i < FLOATING_PIN_READS; i++) {
+    mix(analogRead(floatingPin));
+  }
+  mix(micros());
+  reseedStreams();
+}
+
+void addEntropy(uint16_t value) {
+  if (ticksLeft == 0) {
+    return;
+  }
+  mix(value);
+  mix(micros());
+  if (--ticksLeft == 0) {
+    reseedStreams();
+  }
+}
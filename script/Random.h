@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Arduino.h"
+
+// Small random number generator for the firmware, instead of random()/randomSeed().
+//
+// Each user has its own stream (xorshift32, 4 bytes): one subsystem drawing more numbers does not
+// change the sequence of another. Bounded numbers use a multiplication instead of a division.
+//
+// The streams are seeded from an entropy pool. It starts with a seed that the EEPROM carries from
+// one boot to the next, so two power cycles never start alike, and collects the LSB noise of the
+// ADC and the timing jitter of the loop over the first seconds. Once enough is collected the
+// streams are seeded again.
+
+#define RANDOM_SEED_EEPROM_ADDRESS 448   // behind the file durations (see FileDurations.h), 4 bytes
+#define ENTROPY_TICKS 256                // loop ticks that feed the pool (1.3 - 5 s)
+
+class RandomStream {
+public:
+  explicit RandomStream(uint8_t streamId) : id(streamId) {
+  }
+
+  uint16_t next();
+
+  // minVal..maxVal, both included
+  uint16_t between(uint16_t minVal, uint16_t maxVal);
+
+private:
+  uint32_t state = 0;
+  uint8_t id;
+  uint8_t generation = 0;          // pool generation the stream was seeded from
+};
+
+// --- Entropy Pool ---
+// Call once in setup(), before the ADC is taken by the shake sampling: loads the seed of the last
+// boot, adds the noise of an unconnected analog pin and stores the seed for the next boot
+void beginEntropy(uint8_t floatingPin);
+
+// Call once per tick with a fresh noisy value (e.g. the last ADC sample). Mixes in micros() as well.
+// Does nothing after ENTROPY_TICKS calls
+void addEntropy(uint16_t value);
@@ -0,0 +1,65 @@
+#include "SdCatalogCache.h"
+#include <EEPROM.h>
+
+// --- Record layout ---
+// [magic][size][totalFiles high][totalFiles low][reportedFolders][folderCount][fileCounts 0..size-1][crc]
+const uint8_t SD_CATALOG_MAGIC = 0xC6;  // 0xC5: the record without reportedFolders
+const uint8_t HEADER_LENGTH = 6;
+
+// --- Internal Utility ---
+// CRC-8 (polynomial 0x07) over one byte
+static uint8_t crc8Update(uint8_t crc, uint8_t data) {
+  crc ^= data;
+  for (uint8_t i = 0; i < 8; i++) {
+    crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+  }
+  return crc;
+}
+
+static uint8_t recordCrc(uint8_t size) {
+  uint8_t crc = 0;
+  for (uint8_t i = 0; i < HEADER_LENGTH + size; i++) {
+    crc = crc8Update(crc, EEPROM.read(SD_CATALOG_EEPROM_ADDRESS + i));
+  }
+  return crc;
+}
+
+// --- Implementation ---
+bool loadSdCatalog(uint16_t totalFiles, uint8_t reportedFolders, uint8_t& folderCount, uint8_t* fileCounts, uint8_t size) {
+  const int address = SD_CATALOG_EEPROM_ADDRESS;
+
+  if (EEPROM.read(address) != SD_CATALOG_MAGIC || EEPROM.read(address + 1) != size) {
+    return false;
+  }
+
+  // two cards with the same number of files in another folder layout differ in the folder count
+  uint16_t storedTotalFiles = ((uint16_t)EEPROM.read(address + 2) << 8) | EEPROM.read(address + 3);
+  if (storedTotalFiles != totalFiles || EEPROM.read(address + 4) != reportedFolders) {
+    return false;
+  }
+
+  if (EEPROM.read(address + HEADER_LENGTH + size) != recordCrc(size)) {
+    return false;
+  }
+
+  folderCount = EEPROM.read(address + 5);
+  for (uint8_t i = 0; i < size; i++) {
+    fileCounts[i] = EEPROM.read(address + HEADER_LENGTH + i);
+  }
+  return true;
+}
+
+void storeSdCatalog(uint16_t totalFiles, uint8_t reportedFolders, uint8_t folderCount, const uint8_t* fileCounts, uint8_t size) {
+  const int address = SD_CATALOG_EEPROM_ADDRESS;
+
+  EEPROM.update(address, SD_CATALOG_MAGIC);
+  EEPROM.update(address + 1, size);
+  EEPROM.update(address + 2, (uint8_t)(totalFiles >> 8));
+  EEPROM.update(address + 3, (uint8_t)(totalFiles & 0xFF));
+  EEPROM.update(address + 4, reportedFolders);
+  EEPROM.update(address + 5, folderCount);
+  for (uint8_t i = 0; i < size; i++) {
+    EEPROM.update(address + HEADER_LENGTH + i, fileCounts[i]);
+  }
+  EEPROM.update(address + HEADER_LENGTH + size, recordCrc(size));
+}
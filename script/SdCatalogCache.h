@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Arduino.h"
+
+// EEPROM copy of the SD card catalog (folder count and file count per folder).
+// The record is keyed by a fingerprint (the total file count and the folder count reported by
+// the DFPlayer) and protected by a CRC, so a warm boot with an unchanged card can skip the scan.
+
+#define SD_CATALOG_EEPROM_ADDRESS 0   // start of the record in EEPROM
+
+// Restores folderCount and fileCounts[0..size-1] if the stored record is intact and matches
+// totalFiles and reportedFolders. Returns false (and leaves the arguments untouched) otherwise.
+// folderCount is the count the scan settled on, it can differ from reportedFolders.
+bool loadSdCatalog(uint16_t totalFiles, uint8_t reportedFolders, uint8_t& folderCount, uint8_t* fileCounts, uint8_t size);
+
+// Stores the catalog. Only bytes that changed are written to save EEPROM cycles.
+// The record takes 7 + size bytes and must end before FILE_DURATION_GENERATION_ADDRESS (size <= 56).
+void storeSdCatalog(uint16_t totalFiles, uint8_t reportedFolders, uint8_t folderCount, const uint8_t* fileCounts, uint8_t size);
@@ -0,0 +1,136 @@
+#include "SensorCapture.h"
+
+#if defined(__AVR__)
+#include <avr/interrupt.h>
+#endif
+
+// --- State ---
+static uint8_t pins[SENSOR_CAPTURE_PINS];
+#if defined(__AVR__)
+static volatile uint8_t* pinPorts[SENSOR_CAPTURE_PINS];
+static uint8_t pinMasks[SENSOR_CAPTURE_PINS];
+#endif
+static uint8_t activeLowMask = 0;
+static uint8_t pinCount = 0;
+
+static volatile uint8_t levels = 0;      // bit per sensor, 1 = active
+
+// Ring: the interrupt writes the slot and then the head, loop() reads the slot and then moves the tail
+static SensorEvent events[SENSOR_EVENT_QUEUE_SIZE];
+static volatile uint8_t eventHead = 0;
+static volatile uint8_t eventTail = 0;
+static volatile uint16_t lostEvents = 0;
+
+// --- Internal Utility ---
+// keeps the compiler from moving slot accesses across the index update
+static inline void memoryBarrier() {
+  asm volatile("" ::: "memory");
+}
+
+static uint8_t readLevels() {
+  uint8_t current = 0;
+  for (uint8_t i = 0; i < pinCount; i++) {
+#if defined(__AVR__)
+    bool high = (*pinPorts[i] & pinMasks[i]) != 0;
+#else
+    bool high = digitalRead(pins[i]) == HIGH;
+#endif
+    if (high) {
+      current |= 1 << i;
+    }
+  }
+  return current ^ activeLowMask;
+}
+
+static void pushEvent(uint8_t sensor, bool active, uint32_t time) {
+  uint8_t next = (eventHead + 1) & (SENSOR_EVENT_QUEUE_SIZE - 1);
+  if (next == eventTail) {
+    lostEvents++;
+    return;
+  }
+  events[eventHead].sensor = sensor;
+  events[eventHead].active = active;
+  events[eventHead].time = time;
+  memoryBarrier();
+  eventHead = next;
+}
+
+#if defined(__AVR__)
+ISR(TIMER0_COMPB_vect) {
+  captureSensors();
+}
+#endif
+
+// --- Implementation ---
+uint8_t captureSensorPin(uint8_t pin, bool activeLow) {
+  if (pinCount >= SENSOR_CAPTURE_PINS) {
+    return pinCount - 1;
+  }
+  pins[pinCount] = pin;
+#if defined(__AVR__)
+  pinPorts[pinCount] = portInputRegister(digitalPinToPort(pin));
+  pinMasks[pinCount] = digitalPinToBitMask(pin);
+#endif
+  if (activeLow) {
+    activeLowMask |= 1 << pinCount;
+  }
+  return pinCount++;
+}
+
+void beginSensorCapture() {
+  levels = readLevels();
+  eventHead = eventTail = 0;
+#if defined(__AVR__)
+  // halfway between two millis() overflow interrupts
+  OCR0B = 0x80;
+  TIFR0 = _BV(OCF0B);
+  TIMSK0 |= _BV(OCIE0B);
+#endif
+}
+
+void captureSensors() {
+  uint8_t current = readLevels();
+  uint8_t changed = current ^ levels;
+  if (!changed) {
+    return;
+  }
+  levels = current;
+
+  uint32_t now = millis();
+  for (uint8_t i = 0; i < pinCount; i++) {
+    if (changed & (1 << i)) {
+      pushEvent(i, (current & (1 << i)) != 0, now);
+    }
+  }
+}
+
+void injectSensorLevel(uint8_t sensor, bool active) {
+  uint8_t mask = 1 << sensor;
+  if (((levels & mask) != 0) == active) {
+    return;
+  }
+  levels ^= mask;
+  pushEvent(sensor, active, millis());
+}
+
+bool readSensorEvent(SensorEvent& event) {
+  if (eventTail == eventHead) {
+    return false;
+  }
+  event = events[eventTail];
+  memoryBarrier();
+  eventTail = (eventTail + 1) & (SENSOR_EVENT_QUEUE_SIZE - 1);
+  return true;
+}
+
+bool isSensorActive(uint8_t sensor) {
+  return (levels & (1 << sensor)) != 0;
+}
+
+uint16_t lostSensorEvents() {
+  uint16_t lost;
+  noInterrupts();
+  lost = lostEvents;
+  interrupts();
+  return lost;
+}
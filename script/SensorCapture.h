@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Arduino.h"
+
+// Interrupt driven capture of digital sensor edges. The pins are sampled from the Timer0 compare B
+// interrupt (about every millisecond, Timer0 already runs for millis()) and every change is pushed with
+// its timestamp into a single producer / single consumer ring, which loop() drains. No edge is lost
+// while the loop is busy, and the ring needs no locking: the interrupt only writes the head, loop()
+// only writes the tail.
+// Pin change interrupts are not used because SoftwareSerial defines all PCINT vectors.
+// Timer0 compare B is free as long as analogWrite() is not used on D5.
+
+const uint8_t SENSOR_CAPTURE_PINS = 4;
+const uint8_t SENSOR_EVENT_QUEUE_SIZE = 16;  // power of two
+
+struct SensorEvent {
+  uint8_t sensor;          // id returned by captureSensorPin()
+  bool active;
+  uint32_t time;           // millis() of the sample that saw the change
+};
+
+// --- API ---
+// Adds a pin (before beginSensorCapture). Returns the id used in the events.
+uint8_t captureSensorPin(uint8_t pin, bool activeLow);
+
+// Takes the current levels and starts sampling
+void beginSensorCapture();
+
+// Oldest captured edge. Returns false if there is none.
+bool readSensorEvent(SensorEvent& event);
+
+// Level of the last sample
+bool isSensorActive(uint8_t sensor);
+
+// Edges lost because the ring was full (the levels stay correct)
+uint16_t lostSensorEvents();
+
+// Samples all pins once. Called by the Timer0 interrupt; host builds call it from their clock.
+void captureSensors();
+
+// Sets a sensor level as if it was sampled now (replay of a recorded trace, without beginSensorCapture)
+void injectSensorLevel(uint8_t sensor, bool active);
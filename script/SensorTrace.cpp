@@ -0,0 +1,190 @@
+#include "SensorTrace.h"
+
+// --- Record Types ---
+const uint8_t RECORD_TIME = 0;
+const uint8_t RECORD_LONG_TIME = 1;
+const uint8_t RECORD_EDGE = 2;
+const uint8_t RECORD_SAMPLE = 3;
+const uint8_t RECORD_DELTA = 4;
+
+const uint32_t MAX_LONG_TIME = 0x3FFFFUL;        // 18 bit
+
+// --- Recording State ---
+static Print* traceOutput = nullptr;
+static uint32_t writtenTime = 0;
+static int16_t lastSample = -1;                  // -1: next sample is written in full
+
+static volatile uint16_t samples[TRACE_SAMPLE_QUEUE_SIZE];
+static volatile uint8_t sampleHead = 0;
+static volatile uint8_t sampleTail = 0;
+static volatile uint16_t lostSamples = 0;
+
+// --- Replay State ---
+static Stream* replayInput = nullptr;
+static TraceEdgeHandler edgeHandler = nullptr;
+static TraceSampleHandler sampleHandler = nullptr;
+static uint32_t replayStart = 0;
+static uint32_t replayTime = 0;                  // trace time of the records read so far
+static int16_t replaySample = 0;
+static uint8_t recordHeader = 0;                 // 0: waiting for a header
+static uint8_t recordBytes[2];
+static uint8_t recordBytesRead = 0;
+
+// --- Internal Utility ---
+static void writeRecord(uint8_t type, uint8_t data) {
+  traceOutput->write(0x80 | (type << 4) | (data & 0x0F));
+}
+
+static void writeTime(uint32_t time) {
+  if ((int32_t)(time - writtenTime) <= 0) {
+    return;  // same time (or an edge captured before the last write): no time record
+  }
+  uint32_t delta = time - writtenTime;
+  writtenTime = time;
+
+  while (delta > 0) {
+    if (delta <= 16) {
+      writeRecord(RECORD_TIME, delta - 1);
+      return;
+    }
+    uint32_t chunk = delta > MAX_LONG_TIME ? MAX_LONG_TIME : delta;
+    writeRecord(RECORD_LONG_TIME, chunk >> 14);
+    traceOutput->write(0x80 | ((chunk >> 7) & 0x7F));
+    traceOutput->write(0x80 | (chunk & 0x7F));
+    delta -= chunk;
+  }
+}
+
+static uint8_t recordLength(uint8_t type) {
+  switch (type) {
+    case RECORD_LONG_TIME: return 2;
+    case RECORD_SAMPLE:    return 1;
+    default:               return 0;
+  }
+}
+
+static void applyRecord() {
+  uint8_t type = (recordHeader >> 4) & 0x07;
+  uint8_t data = recordHeader & 0x0F;
+
+  switch (type) {
+    case RECORD_TIME:
+      replayTime += data + 1;
+      break;
+    case RECORD_LONG_TIME:
+      replayTime += ((uint32_t)data << 14) | ((uint16_t)(recordBytes[0] & 0x7F) << 7) | (recordBytes[1] & 0x7F);
+      break;
+    case RECORD_EDGE:
+      if (edgeHandler) {
+        edgeHandler(data >> 1, data & 0x01);
+      }
+      break;
+    case RECORD_SAMPLE:
+      replaySample = ((data & 0x07) << 7) | (recordBytes[0] & 0x7F);
+      if (sampleHandler) {
+        sampleHandler(replaySample);
+      }
+      break;
+    case RECORD_DELTA:
+      replaySample += (int8_t)data - 8;
+      if (sampleHandler) {
+        sampleHandler(replaySample);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+// --- Recording ---
+void beginTraceRecording(Print& output) {
+  traceOutput = &output;
+  writtenTime = millis();
+  lastSample = -1;
+  sampleHead = sampleTail = 0;
+}
+
+void traceEdge(uint8_t sensor, bool active, uint32_t time) {
+  if (!traceOutput) {
+    return;
+  }
+  writeTime(time);
+  writeRecord(RECORD_EDGE, (sensor << 1) | (active ? 1 : 0));
+}
+
+void traceShakeSample(uint16_t sample) {
+  uint8_t next = (sampleHead + 1) & (TRACE_SAMPLE_QUEUE_SIZE - 1);
+  if (next == sampleTail) {
+    lostSamples++;
+    return;
+  }
+  samples[sampleHead] = sample;
+  sampleHead = next;
+}
+
+void flushTrace() {
+  if (!traceOutput) {
+    return;
+  }
+  if (sampleTail != sampleHead) {
+    writeTime(millis());
+  }
+  while (sampleTail != sampleHead) {
+    int16_t sample = samples[sampleTail];
+    sampleTail = (sampleTail + 1) & (TRACE_SAMPLE_QUEUE_SIZE - 1);
+
+    int16_t delta = sample - lastSample;
+    if (lastSample >= 0 && delta >= -8 && delta <= 7) {
+      writeRecord(RECORD_DELTA, delta + 8);
+    } else {
+      writeRecord(RECORD_SAMPLE, sample >> 7);
+      traceOutput->write(0x80 | (sample & 0x7F));
+    }
+    lastSample = sample;
+  }
+}
+
+uint16_t lostTraceSamples() {
+  noInterrupts();
+  uint16_t lost = lostSamples;
+  interrupts();
+  return lost;
+}
+
+// --- Replay ---
+void beginTraceReplay(Stream& input, TraceEdgeHandler onEdge, TraceSampleHandler onSample) {
+  replayInput = &input;
+  edgeHandler = onEdge;
+  sampleHandler = onSample;
+  replayStart = millis();
+  replayTime = 0;
+  replaySample = 0;
+  recordHeader = 0;
+  recordBytesRead = 0;
+}
+
+void replayTrace() {
+  if (!replayInput) {
+    return;
+  }
+
+  // stop at the first record that lies in the future, the stream keeps the rest
+  while ((int32_t)(millis() - replayStart - replayTime) >= 0 && replayInput->available() > 0) {
+    int byteIn = replayInput->read();
+    if (byteIn < 0x80) {
+      continue;  // log output between the records
+    }
+
+    if (recordHeader == 0) {
+      recordHeader = byteIn;
+      recordBytesRead = 0;
+    } else {
+      recordBytes[recordBytesRead++] = byteIn;
+    }
+
+    if (recordBytesRead == recordLength((recordHeader >> 4) & 0x07)) {
+      applyRecord();
+      recordHeader = 0;
+    }
+  }
+}
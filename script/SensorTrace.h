@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Arduino.h"
+
+// Recording and replay of the sensor inputs of loop(): hand, room and button edges and the raw ADC
+// samples of the shake sensor, as a compact binary stream.
+//
+// Every byte of a record has bit 7 set, the replay skips all bytes below 0x80. The binary log
+// (Log.h) can not share the port, it is off while tracing. A record is a header byte 1TTT DDDD:
+//   T=0 time       +DDDD+1 ms
+//   T=1 long time  +(DDDD << 14 | 7 bit | 7 bit) ms, two more bytes
+//   T=2 edge       DDDD = sensor << 1 | active
+//   T=3 sample     DDDD = bits 9-7 of a shake sample, one more byte with bits 6-0
+//   T=4 delta      DDDD = difference to the previous shake sample + 8 (-8..7)
+// Records without a time record in between happened at the same time. At ~1 kHz shake samples a
+// trace needs about 1.2 kB/s, so recording needs a fast serial port (SENSOR_TRACE_BAUD).
+
+enum TraceSensor : uint8_t {
+  TRACE_HAND,
+  TRACE_ROOM,
+  TRACE_BUTTON1,
+  TRACE_BUTTON2,
+  TRACE_BUTTON3
+};
+
+const uint8_t TRACE_SAMPLE_QUEUE_SIZE = 32;  // power of two, shake samples between two flushes
+
+// --- Recording ---
+void beginTraceRecording(Print& output);
+void traceEdge(uint8_t sensor, bool active, uint32_t time);
+void traceShakeSample(uint16_t sample);      // called from the ADC interrupt
+void flushTrace();                           // once per tick: writes the queued shake samples
+uint16_t lostTraceSamples();                 // samples dropped because the queue was full
+
+// --- Replay ---
+typedef void (*TraceEdgeHandler)(uint8_t sensor, bool active);
+typedef void (*TraceSampleHandler)(uint16_t sample);
+
+// Replays the records of input with their original timing, starting now
+void beginTraceReplay(Stream& input, TraceEdgeHandler onEdge, TraceSampleHandler onSample);
+// Once per tick, before the sensors are evaluated: hands all due records to the handlers
+void replayTrace();
@@ -0,0 +1,109 @@
+#include "ShakeDetector.h"
+
+#if defined(__AVR__)
+#include <avr/interrupt.h>
+#endif
+
+// --- Detector ---
+ShakeDetector::ShakeDetector(uint8_t decayShift, uint16_t triggerEnergy, uint16_t releaseEnergy) :
+  decayShift(decayShift), triggerEnergy(triggerEnergy), releaseEnergy(releaseEnergy) {
+}
+
+void ShakeDetector::addSample(uint16_t sample) {
+  lastSample = sample;
+  if (!hasBaseline) {
+    baseline = sample << 6;
+    hasBaseline = true;
+  }
+
+  // baseline += (sample - baseline) / 64, kept in 1/64 steps. Subtract first, so it never exceeds 16 bit
+  baseline -= baseline >> 6;
+  baseline += sample;
+
+  uint16_t level = baseline >> 6;
+  uint16_t deviation = sample > level ? sample - level : level - sample;
+
+  uint16_t energy = currentEnergy;
+  energy -= energy >> decayShift;
+  energy = (energy > 0xFFFF - deviation) ? 0xFFFF : energy + deviation;
+  currentEnergy = energy;
+
+  if (energy > peakEnergy) {
+    peakEnergy = energy;
+  }
+
+  if (!triggered && energy >= triggerEnergy) {
+    triggered = true;
+    if (incidents < 0xFF) {
+      incidents++;
+    }
+  } else if (triggered && energy < releaseEnergy) {
+    triggered = false;
+  }
+}
+
+bool ShakeDetector::takeIncident() {
+  bool incident = false;
+  noInterrupts();
+  if (incidents > 0) {
+    incidents--;
+    incident = true;
+  }
+  interrupts();
+  return incident;
+}
+
+uint16_t ShakeDetector::energy() {
+  noInterrupts();
+  uint16_t energy = currentEnergy;
+  interrupts();
+  return energy;
+}
+
+uint16_t ShakeDetector::takePeakEnergy() {
+  noInterrupts();
+  uint16_t peak = peakEnergy;
+  peakEnergy = currentEnergy;
+  interrupts();
+  return peak;
+}
+
+void ShakeDetector::reset() {
+  noInterrupts();
+  currentEnergy = 0;
+  incidents = 0;
+  triggered = false;
+  interrupts();
+}
+
+// --- ADC Sampling ---
+static ShakeDetector* sampledDetector = nullptr;
+static void (*sampleTap)(uint16_t sample) = nullptr;
+
+#if defined(__AVR__)
+ISR(ADC_vect) {
+  uint16_t sample = ADC;
+  if (sampledDetector) {
+    sampledDetector->addSample(sample);
+  }
+  if (sampleTap) {
+    sampleTap(sample);
+  }
+}
+#endif
+
+void beginShakeSampling(uint8_t analogPin, ShakeDetector& detector) {
+  sampledDetector = &detector;
+#if defined(__AVR__)
+  uint8_t channel = analogPin >= A0 ? analogPin - A0 : analogPin;
+  ADMUX = _BV(REFS0) | (channel & 0x07);       // AVcc reference, like analogRead()
+  ADCSRB = _BV(ADTS2);                         // auto trigger: Timer0 overflow (the millis() tick)
+  ADCSRA = _BV(ADEN) | _BV(ADATE) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+#else
+  (void)analogPin;  // host builds call addSample() directly
+#endif
+}
+
+void setShakeSampleTap(void (*tap)(uint16_t sample)) {
+  sampleTap = tap;
+}
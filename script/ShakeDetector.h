@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Arduino.h"
+
+// Energy based shake detection. Every ADC sample of the shake sensor goes through:
+//  - a slow baseline (moving average, 1/64 per sample) that follows the resting level of the sensor
+//  - the deviation from the baseline, integrated by a leaky integrator:
+//      energy = energy - energy / 2^decayShift + deviation
+//    A constant deviation d settles at d * 2^decayShift, a single spike decays within about 2^decayShift samples.
+//  - a trigger with hysteresis: an incident is counted when the energy rises above triggerEnergy,
+//    the next one only after it fell below releaseEnergy.
+// Integer only (16 bit), so addSample() is cheap enough for the ADC interrupt.
+
+class ShakeDetector {
+public:
+  ShakeDetector(uint8_t decayShift, uint16_t triggerEnergy, uint16_t releaseEnergy);
+
+  // Processes one ADC sample (0-1023). Called from the ADC interrupt.
+  void addSample(uint16_t sample);
+
+  // True once per incident
+  bool takeIncident();
+
+  // Current energy, and the highest energy since the last call of takePeakEnergy() (for tuning the thresholds)
+  uint16_t energy();
+  uint16_t takePeakEnergy();
+
+  // Forget the energy, e.g. after a shake was handled
+  void reset();
+
+  // The last raw sample, not read atomically: good enough as noise for the random generator
+  uint16_t latestSample() { return lastSample; }
+
+private:
+  uint8_t decayShift;
+  uint16_t triggerEnergy;
+  uint16_t releaseEnergy;
+
+  uint16_t baseline = 0;              // resting level in 1/64 steps
+  bool hasBaseline = false;
+  volatile uint16_t currentEnergy = 0;
+  volatile uint16_t peakEnergy = 0;
+  bool triggered = false;
+  volatile uint8_t incidents = 0;
+  volatile uint16_t lastSample = 0;
+};
+
+// Samples analogPin on every Timer0 overflow (about 1 kHz) with the ADC interrupt and feeds detector.
+// analogRead() can not be used while sampling runs. Host builds call addSample() directly instead.
+void beginShakeSampling(uint8_t analogPin, ShakeDetector& detector);
+
+// Additionally hands every sample to tap (in the interrupt), e.g. to record a trace
+void setShakeSampleTap(void (*tap)(uint16_t sample));
@@ -1,73 +1,70 @@
 #include <Arduino.h>
 
-#ifndef COUNTER_SIZE
-  #define COUNTER_SIZE        3
-#endif
-
+// Counts events within a sliding time window, e.g. "COUNTER_SIZE shakes within 4 s".
+// N timestamps are kept in a ring in the order they were added, so the oldest one is always next to
+// be overwritten: adding and the newest time are O(1) (expired entries are dropped lazily).
+// TimeT can be uint32_t (millis()) or uint16_t to halve the RAM; then pass (uint16_t)millis()
+// or a coarser tick. Comparisons are done on the difference, so rollover of TimeT is harmless as
+// long as the window is below half of its range and expire() is called at least once per
+// half range: an expired time that is not dropped in time looks recent again after a wrap.
+template<uint8_t N, typename TimeT = uint32_t>
 class TimeBasedCounter {
 private:
-  unsigned long times[COUNTER_SIZE];
-  unsigned long withinTime;
+  TimeT times[N];
+  TimeT withinTime;
+  TimeT latest = 0;
+  uint8_t oldest = 0;   // index of the oldest stored time
+  uint8_t count = 0;    // stored times within the window (at the last check)
+
+  bool isWithin(TimeT currentTime, TimeT time) const {
+    return (TimeT)(currentTime - time) <= withinTime;
+  }
 
 public:
-  TimeBasedCounter(unsigned long window = 5000) : withinTime(window) {
-    for (uint8_t i = 0; i < COUNTER_SIZE; i++) {
-      times[i] = 0 - withinTime;  // initialize with offset
-    }
+  TimeBasedCounter(TimeT window = 5000) : withinTime(window) {
   }
 
-  // Add current time and check if all COUNTER_SIZE are within the window
-  bool addTimeAndCheck(unsigned long currentTime) {
-    for (uint8_t i = 0; i < COUNTER_SIZE; i++) {
-      if ((unsigned long)(currentTime - times[i]) > withinTime) {
-        times[i] = currentTime;
-        return false;
-      }
+  // Add current time and check if N events happened within the window.
+  // If so, the stored times are cleared (and the current time is not stored)
+  bool addTimeAndCheck(TimeT currentTime) {
+    expire(currentTime);
+    latest = currentTime;
+
+    if (count == N) {
+      reset();
+      return true;  // All timestamps are within the window
     }
 
-    reset();
-    return true; // All timestamps are within the window
+    times[(oldest + count) % N] = currentTime;
+    count++;
+    return false;
   }
 
-  // Reset all stored by shifting them back timestamps
-  void reset() {
-    for (uint8_t i = 0; i < COUNTER_SIZE; i++) {
-      times[i] = times[i] - withinTime;
+  // Drop the times that left the window
+  void expire(TimeT currentTime) {
+    while (count > 0 && !isWithin(currentTime, times[oldest])) {
+      oldest = (oldest + 1) % N;
+      count--;
     }
   }
 
-  // Count how many events occurred within the window
-  uint8_t getCurrentShakeCounter(unsigned long currentTime) const {
-    uint8_t counter = 0;
-    for (uint8_t i = 0; i < COUNTER_SIZE; i++) {
-      if ((unsigned long)(currentTime - times[i]) <= withinTime) {
-#ifdef DEBUG
-        Serial.print("Current time ");
-        Serial.print(currentTime);
-        Serial.print(" minus times[i] ");
-        Serial.print(times[i]);
-        Serial.print(" is ");
-        Serial.print(currentTime - times[i]);
-        Serial.print(" and therefore smaller than ");
-        Serial.println(withinTime);
-#endif
-        counter++;
-      }
-    }
-    return counter;
+  // Forget all stored times
+  void reset() {
+    count = 0;
   }
 
-  // Get the latest timestamp from the stored values
-  unsigned long getLatestTime() const {
-    unsigned long newest = times[0];
-    for (uint8_t i = 1; i < COUNTER_SIZE; i++) {
-      // For explanation, google
-      // "Modular (or Unsigned) Time Comparison"
-      // "Half-range unsigned comparison"
-      if ((unsigned long)(times[i] - newest) < 0x80000000UL) {
-        newest = times[i];
-      }
+  // Count how many events occurred within the window. The times are in order, so the ones that
+  // left the window are the oldest.
+  uint8_t getCurrentCount(TimeT currentTime) const {
+    uint8_t expired = 0;
+    while (expired < count && !isWithin(currentTime, times[(oldest + expired) % N])) {
+      expired++;
     }
-    return newest;
+    return count - expired;
+  }
+
+  // Get the time of the latest event
+  TimeT getLatestTime() const {
+    return latest;
   }
-};
\ No newline at end of file
+};
@@ -0,0 +1,111 @@
+#include "Timeline.h"
+
+// --- Constants ---
+// On serial an event is 9 bytes: sync, kind, trigger, time (4 bytes), arg (2 bytes), little endian.
+// kind is N PP TTTTT: N set when the event starts a new trigger, P the phase, T the track.
+// Trigger 0 is "no cause", the ids wrap around after 255.
+enum TimelinePhase : uint8_t {
+  PHASE_BEGIN,
+  PHASE_END,
+  PHASE_INSTANT
+};
+
+const uint8_t NEW_TRIGGER = 0x80;
+const uint8_t EVENT_LENGTH = 9;
+
+// --- State ---
+// about 150 bytes of RAM. Without TIMELINE nothing references them and the linker drops them.
+struct TimelineEntry {
+  uint8_t kind;
+  uint8_t trigger;
+  uint32_t time;
+  int16_t arg;
+};
+
+static TimelineEntry ring[TIMELINE_RING_SIZE];
+static uint8_t head = 0;
+static uint8_t tail = 0;
+
+static uint8_t currentTrigger = 0;
+static uint8_t lastTrigger = 0;
+static uint8_t trackTrigger[TIMELINE_TRACKS];
+
+// --- Internal Utility ---
+// events that do not fit are dropped, the host sees the gap in the times only
+static void record(uint8_t kind, uint32_t time, int16_t arg) {
+  uint8_t next = (head + 1) & (TIMELINE_RING_SIZE - 1);
+  if (next == tail) {
+    return;
+  }
+  ring[head].kind = kind;
+  ring[head].trigger = currentTrigger;
+  ring[head].time = time;
+  ring[head].arg = arg;
+  head = next;
+}
+
+static void startTrigger(uint8_t track) {
+  if (++lastTrigger == 0) {
+    lastTrigger = 1;
+  }
+  currentTrigger = lastTrigger;
+  trackTrigger[track] = currentTrigger;
+}
+
+static void writeValue(Stream& output, uint32_t value, uint8_t bytes) {
+  for (uint8_t i = 0; i < bytes; i++) {
+    output.write((uint8_t)(value >> (8 * i)));
+  }
+}
+
+// --- Implementation ---
+void timelineEdge(uint8_t track, bool active, uint32_t edgeMillis) {
+  uint32_t time = micros() - (millis() - edgeMillis) * 1000UL;
+  if (active) {
+    startTrigger(track);
+    record(NEW_TRIGGER | PHASE_BEGIN << 5 | track, time, 0);
+  } else {
+    timelineResume(track);
+    record(PHASE_END << 5 | track, time, 0);
+  }
+}
+
+void timelineTrigger(uint8_t track, int16_t arg) {
+  startTrigger(track);
+  record(NEW_TRIGGER | PHASE_INSTANT << 5 | track, micros(), arg);
+}
+
+void timelineBegin(uint8_t track, int16_t arg) {
+  trackTrigger[track] = currentTrigger;
+  record(PHASE_BEGIN << 5 | track, micros(), arg);
+}
+
+void timelineEnd(uint8_t track, int16_t arg) {
+  timelineResume(track);
+  record(PHASE_END << 5 | track, micros(), arg);
+}
+
+void timelineInstant(uint8_t track, int16_t arg) {
+  trackTrigger[track] = currentTrigger;
+  record(PHASE_INSTANT << 5 | track, micros(), arg);
+}
+
+void timelineResume(uint8_t track) {
+  currentTrigger = trackTrigger[track];
+}
+
+void timelineNoCause() {
+  currentTrigger = 0;
+}
+
+void flushTimeline(Stream& output) {
+  while (tail != head && output.availableForWrite() >= EVENT_LENGTH) {
+    const TimelineEntry& entry = ring[tail];
+    output.write(TIMELINE_SYNC);
+    output.write(entry.kind);
+    output.write(entry.trigger);
+    writeValue(output, entry.time, 4);
+    writeValue(output, (uint16_t)entry.arg, 2);
+    tail = (tail + 1) & (TIMELINE_RING_SIZE - 1);
+  }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Arduino.h"
+
+// End-to-end timeline of what the unit does, to measure e.g. hand sensor -> pump -> play command ->
+// bird out. Define TIMELINE before including this header to enable it; without it the macros compile
+// to nothing.
+//
+// Every event is on a track (TimelineTracks.h): a begin, an end or an instant with a micros() time
+// and a 16 bit value. It also carries the trigger that caused it. A sensor edge or shake incident
+// starts a new trigger, what follows in the same code path belongs to it. A begin or instant
+// remembers the trigger on its track, and later work continues it from there: the end of a job,
+// the steps of the bird (sound job), the answer of the DFPlayer (last sent frame), or loop() acting
+// on a sensor that is still active. The events wait in a RAM ring like the log records
+// and go to serial with flushTimeline(); tools/timelineToChrome.py turns them into a Chrome trace.
+
+// --- Tracks ---
+enum TimelineTrack : uint8_t {
+#define TIMELINE_TRACK(id, name) id,
+#include "TimelineTracks.h"
+#undef TIMELINE_TRACK
+  TIMELINE_TRACKS
+};
+
+const uint8_t TIMELINE_RING_SIZE = 16;   // events (8 bytes each), power of two
+const uint8_t TIMELINE_SYNC = 0xA6;      // first byte of an event on serial, see Timeline.cpp
+
+// --- API ---
+// A sensor edge at edgeMillis (millis() of the capture): active starts a new trigger and begins
+// the track, inactive ends it. The event is dated back to the edge.
+void timelineEdge(uint8_t track, bool active, uint32_t edgeMillis);
+
+// Starts a new trigger with an instant on track
+void timelineTrigger(uint8_t track, int16_t arg = 0);
+
+void timelineBegin(uint8_t track, int16_t arg = 0);
+void timelineEnd(uint8_t track, int16_t arg = 0);      // continues the trigger of the begin
+void timelineInstant(uint8_t track, int16_t arg = 0);
+
+// Continues the trigger of the last begin or instant on track, e.g. where loop() acts on a sensor
+void timelineResume(uint8_t track);
+
+// Nothing causes what follows (start of a tick)
+void timelineNoCause();
+
+// Writes as many events as output takes without waiting
+void flushTimeline(Stream& output);
+
+// --- Macros ---
+#ifdef TIMELINE
+  #define TIMELINE_EDGE(track, active, edgeMillis) timelineEdge(track, active, edgeMillis)
+  #define TIMELINE_TRIGGER(...) timelineTrigger(__VA_ARGS__)
+  #define TIMELINE_RESUME(track) timelineResume(track)
+  #define TIMELINE_NO_CAUSE() timelineNoCause()
+  #define TIMELINE_FLUSH(output) flushTimeline(output)
+#else
+  #define TIMELINE_EDGE(track, active, edgeMillis)
+  #define TIMELINE_TRIGGER(...)
+  #define TIMELINE_RESUME(track)
+  #define TIMELINE_NO_CAUSE()
+  #define TIMELINE_FLUSH(output)
+#endif
@@ -0,0 +1,26 @@
+// Timeline tracks: id and name. No include guard, this list is included by Timeline.h with different
+// definitions of TIMELINE_TRACK. tools/timelineToChrome.py reads the names from this file, each track
+// becomes a row of the trace. At most 32 tracks, only append new tracks at the end.
+
+// --- Sensors and buttons ---
+TIMELINE_TRACK(TRACK_HAND, "hand sensor")
+TIMELINE_TRACK(TRACK_ROOM, "room sensor")
+TIMELINE_TRACK(TRACK_SHAKE, "shake incidents")
+TIMELINE_TRACK(TRACK_BUTTON1, "button 1")
+TIMELINE_TRACK(TRACK_BUTTON2, "button 2")
+TIMELINE_TRACK(TRACK_BUTTON3, "button 3")
+
+// --- Jobs ---
+TIMELINE_TRACK(TRACK_SOAP, "soap job (pump)")
+TIMELINE_TRACK(TRACK_ROOM_JOB, "room job")
+TIMELINE_TRACK(TRACK_SHAKE_JOB, "shake job")
+TIMELINE_TRACK(TRACK_SOUND, "sound job")
+
+// --- DFPlayer frames (arg: command << 8 | low byte of the parameter) ---
+TIMELINE_TRACK(TRACK_DFPLAYER_SENT, "DFPlayer sent")
+TIMELINE_TRACK(TRACK_DFPLAYER_RECEIVED, "DFPlayer received")
+
+// --- Bird ---
+TIMELINE_TRACK(TRACK_BIRD_OUT, "bird out")
+TIMELINE_TRACK(TRACK_FLAP, "flap")
+TIMELINE_TRACK(TRACK_BIRD_IN, "bird in")
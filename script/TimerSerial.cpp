@@ -0,0 +1,160 @@
+/*!
+ * @file TimerSerial.cpp
+ * @brief Implementation of the Timer2 based serial port declared in TimerSerial.h.
+ */
+
+#include "TimerSerial.h"
+
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
+
+#include <avr/interrupt.h>
+
+TimerSerial* TimerSerial::_active = nullptr;
+
+ISR(TIMER2_COMPA_vect) {
+    TimerSerial::handleInterrupt();
+}
+
+TimerSerial::TimerSerial(uint8_t rxPin, uint8_t txPin) :
+    _rxPin(rxPin), _txPin(txPin),
+    _rxHead(0), _rxTail(0), _txHead(0), _txTail(0), _overflows(0),
+    _rxTicks(0), _rxBits(0), _rxByte(0), _txTicks(0), _txBits(0), _txShift(0) {
+}
+
+void TimerSerial::begin(long speed) {
+    end();
+
+    pinMode(_rxPin, INPUT_PULLUP);
+    pinMode(_txPin, OUTPUT);
+    digitalWrite(_txPin, HIGH);  // idle level
+    _rxPort = portInputRegister(digitalPinToPort(_rxPin));
+    _rxMask = digitalPinToBitMask(_rxPin);
+    _txPort = portOutputRegister(digitalPinToPort(_txPin));
+    _txMask = digitalPinToBitMask(_txPin);
+
+    _rxHead = _rxTail = 0;
+    _txHead = _txTail = 0;
+    _rxTicks = 0;
+    _txTicks = 0;
+    _active = this;
+
+    // Timer2 in CTC mode, prescaler 8, interrupt at three times the baud rate
+    uint8_t oldSREG = SREG;
+    cli();
+    TCCR2A = _BV(WGM21);
+    TCCR2B = _BV(CS21);
+    OCR2A = (uint8_t)(F_CPU / 8 / (3 * speed) - 1);
+    TCNT2 = 0;
+    TIFR2 = _BV(OCF2A);
+    TIMSK2 = _BV(OCIE2A);
+    SREG = oldSREG;
+}
+
+void TimerSerial::end() {
+    if (_active == this) {
+        TIMSK2 &= ~_BV(OCIE2A);
+        _active = nullptr;
+    }
+}
+
+int TimerSerial::available() {
+    return (uint8_t)(_rxHead - _rxTail + TIMER_SERIAL_RX_SIZE) % TIMER_SERIAL_RX_SIZE;
+}
+
+int TimerSerial::read() {
+    if (_rxHead == _rxTail) {
+        return -1;
+    }
+    uint8_t byteIn = _rxBuffer[_rxTail];
+    _rxTail = (_rxTail + 1) % TIMER_SERIAL_RX_SIZE;
+    return byteIn;
+}
+
+int TimerSerial::peek() {
+    return (_rxHead == _rxTail) ? -1 : _rxBuffer[_rxTail];
+}
+
+size_t TimerSerial::write(uint8_t byteOut) {
+    if (_active != this) {
+        return 0;
+    }
+    uint8_t next = (_txHead + 1) % TIMER_SERIAL_TX_SIZE;
+    while (next == _txTail) {
+        // buffer full, the interrupt frees a slot within about one byte time
+    }
+    _txBuffer[_txHead] = byteOut;
+    _txHead = next;
+    return 1;
+}
+
+int TimerSerial::availableForWrite() {
+    return TIMER_SERIAL_TX_SIZE - 1 - (uint8_t)(_txHead - _txTail + TIMER_SERIAL_TX_SIZE) % TIMER_SERIAL_TX_SIZE;
+}
+
+void TimerSerial::flush() {
+    while (_active == this && (_txHead != _txTail || _txTicks != 0)) {
+        // wait for the interrupt to send the rest
+    }
+}
+
+void TimerSerial::handleInterrupt() {
+    if (_active) {
+        _active->tick();
+    }
+}
+
+// One third of a bit. Keep this short, it runs about 29000 times per second at 9600 baud.
+void TimerSerial::tick() {
+    // --- receive ---
+    bool level = (*_rxPort & _rxMask) != 0;
+    if (_rxTicks == 0) {
+        if (!level) {
+            // Start bit. The edge was within the last third of a bit, so sampling four ticks
+            // later hits the middle third of the first data bit.
+            _rxTicks = 4;
+            _rxBits = 0;
+            _rxByte = 0;
+        }
+    } else if (--_rxTicks == 0) {
+        if (_rxBits < 8) {
+            _rxByte >>= 1;
+            if (level) _rxByte |= 0x80;
+            _rxBits++;
+            _rxTicks = 3;
+        } else {
+            // Stop bit, a low level here is a framing error and the byte is discarded
+            if (level) {
+                uint8_t next = (_rxHead + 1) % TIMER_SERIAL_RX_SIZE;
+                if (next != _rxTail) {
+                    _rxBuffer[_rxHead] = _rxByte;
+                    _rxHead = next;
+                } else {
+                    _overflows++;
+                }
+            }
+            // _rxTicks stays 0: wait for the next start bit
+        }
+    }
+
+    // --- transmit ---
+    if (_txTicks == 0) {
+        if (_txHead != _txTail) {
+            _txShift = _txBuffer[_txTail] | 0x100;  // stop bit after the data bits
+            _txTail = (_txTail + 1) % TIMER_SERIAL_TX_SIZE;
+            _txBits = 9;
+            *_txPort &= ~_txMask;                   // start bit
+            _txTicks = 3;
+        }
+    } else if (--_txTicks == 0) {
+        if (_txBits > 0) {
+            if (_txShift & 0x01) *_txPort |= _txMask;
+            else                 *_txPort &= ~_txMask;
+            _txShift >>= 1;
+            _txBits--;
+            _txTicks = 3;
+        }
+        // after the stop bit _txTicks stays 0 and the next byte starts on the next tick
+    }
+}
+
+#endif  // __AVR_ATmega328P__ || __AVR_ATmega168__
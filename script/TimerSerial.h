@@ -0,0 +1,84 @@
+/*!
+ * @file TimerSerial.h
+ * @brief Interrupt driven software serial port on Timer2 (ATmega328P / Arduino Nano)
+ *
+ * SoftwareSerial busy-waits with interrupts off for every bit: sending a 10-byte DFPlayer frame
+ * costs about 10 ms of dead CPU time at 9600 baud. TimerSerial samples and drives the pins from
+ * a Timer2 interrupt at three times the baud rate instead. write() only fills a buffer and returns,
+ * receiving never blocks, and both directions run at the same time (full duplex).
+ *
+ * The interrupt costs roughly 10 % CPU at 9600 baud, spread evenly. Timer2 can not be used for
+ * anything else meanwhile (PWM on D3/D11, tone()). Only one instance can be active.
+ *
+ * Any Stream works with DFRobotDFPlayerMini: TimerSerial, SoftwareSerial, a hardware UART
+ * (HardwareSerial is already buffered and interrupt driven) or DFPlayerEmulator on a host.
+ */
+
+#ifndef TimerSerial_h
+#define TimerSerial_h
+
+#include <Arduino.h>
+
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
+
+#ifndef TIMER_SERIAL_RX_SIZE
+#define TIMER_SERIAL_RX_SIZE 32
+#endif
+#ifndef TIMER_SERIAL_TX_SIZE
+#define TIMER_SERIAL_TX_SIZE 32       // fits three DFPlayer frames
+#endif
+
+class TimerSerial : public Stream {
+public:
+    TimerSerial(uint8_t rxPin, uint8_t txPin);
+
+    // Starts Timer2. Supported: 2400 to 19200 baud at 16 MHz.
+    void begin(long speed);
+    void end();
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    // Buffers the byte and returns. Only waits if the transmit buffer is full.
+    size_t write(uint8_t byteOut) override;
+    using Print::write;
+    int availableForWrite() override;
+    void flush() override;            // Wait until all buffered bytes are sent
+
+    uint16_t overflows() { return _overflows; }  // received bytes lost because the buffer was full
+
+    // Called by the Timer2 interrupt
+    static void handleInterrupt();
+
+private:
+    static TimerSerial* _active;
+
+    uint8_t _rxPin;
+    uint8_t _txPin;
+    volatile uint8_t* _rxPort;
+    uint8_t _rxMask;
+    volatile uint8_t* _txPort;
+    uint8_t _txMask;
+
+    volatile uint8_t _rxBuffer[TIMER_SERIAL_RX_SIZE];
+    volatile uint8_t _rxHead;
+    volatile uint8_t _rxTail;
+    volatile uint8_t _txBuffer[TIMER_SERIAL_TX_SIZE];
+    volatile uint8_t _txHead;
+    volatile uint8_t _txTail;
+    volatile uint16_t _overflows;
+
+    // Bit state machines, only touched by the interrupt. A tick is a third of a bit.
+    uint8_t _rxTicks;                 // ticks until the next sample, 0 = waiting for a start bit
+    uint8_t _rxBits;
+    uint8_t _rxByte;
+    volatile uint8_t _txTicks;        // ticks until the next bit, 0 = idle (read by flush())
+    uint8_t _txBits;
+    uint16_t _txShift;                // data bits followed by the stop bit
+
+    void tick();
+};
+
+#endif  // __AVR_ATmega328P__ || __AVR_ATmega168__
+
+#endif  // TimerSerial_h
@@ -1,35 +1,73 @@
 #include "Arduino.h"
 #include "SoftwareSerial.h"
 #include "DFRobotDFPlayerMini.h"
+#include "DFPlayerEmulator.h"
+#include "TimerSerial.h"
 #include "JobManager.cpp"
 #include "TimeBasedCounter.cpp"
 #include "BirdFlapGenerator.h"
+#include "Choreography.h"
+#include "SdCatalogCache.h"
+#include "FileDurations.h"
 #include "Bounce2.h"
+#include "IdleSleep.h"
+#include "SensorCapture.h"
+#include "ShakeDetector.h"
+#include "SensorTrace.h"
+#include "Random.h"
 
 //----------------------------------------
 //Install the following libraries from your arduino library manager
 //https://github.com/thomasfredericks/Bounce2
-//https://github.com/end2endzone/SoftTimers
 
 // use the old bootloader for arduino nano when compiling
 
 
-// uncomment this line, if you want to show logs on serial:
+// uncomment this line, if you want to log on serial: 1 errors, 2 what the unit does, 3 details.
+// The log is binary (9600 baud), decode it with tools/logDecode.py. See Log.h
 
-// #define DEBUG
+// #define LOG_LEVEL 2
+
+// uncomment this line, if you want to run without a DFPlayer module (bench testing). An emulator answers instead:
+
+// #define DFPLAYER_EMULATOR
+
+// uncomment this line, if the DFPlayer should be connected through the Timer2 serial port instead of SoftwareSerial.
+// Sending does not block the loop anymore (SoftwareSerial blocks ~1ms per byte). Timer2 PWM (D3, D11) is not available then
+
+// #define DFPLAYER_TIMER_SERIAL
+
+// uncomment this line, to measure how long the loop and its parts take (send 'p' over serial to print the histograms)
+
+// #define LOOP_PROFILER
+
+// uncomment one of these lines, to record the sensors (hand, room, buttons, shake samples) as binary trace over serial,
+// or to replay such a trace from serial instead of reading the sensors. See SensorTrace.h
+
+// #define SENSOR_TRACE_RECORD
+// #define SENSOR_TRACE_REPLAY
+
+// uncomment this line, to send a timeline of sensor edges, jobs, DFPlayer frames and bird moves over serial.
+// tools/timelineToChrome.py turns it into a Chrome trace and measures trigger to sound and bird. See Timeline.h
+
+// #define TIMELINE
 //----------------------------------------
 // Settings
 
 #define VOLUME 23                         // sound volume 0-30
 
-#define SHAKE_SENSITIVITY 20              // up to 1024. The higher the number, the lower the sensitivity
-#define SHAKE_PICKUP_SPEED 150            // minimum time in ms between shake incidents to get registered
+#define SHAKE_TRIGGER_ENERGY 320          // shake energy for a shake incident. The higher the number, the lower the sensitivity
+#define SHAKE_RELEASE_ENERGY 80           // the energy has to fall below this before the next incident counts
+#define SHAKE_DECAY_SHIFT 4               // energy decays by 1/2^n per sample (1 kHz). A steady deviation d settles at d * 2^n
 #define SHAKE_OBSERVATION_WINDOW 4000     // Window to observe shakes in ms
 #define COUNTER_SIZE 3                    // how many times should the sensor detect a shake within the window 
 #define SHAKE_DETECTION_TIMEOUT 10000     // how much time after the last shake execution (Pfoten weg) before the shake sensor is active again (ms)?
 
 #define ROOM_DETECTION_TIMEOUT 60000      // how much time after the last activity before the room sensor is active (ms)?
 
+#define SOUND_MAX_DURATION 15000          // safety time for sounds with unknown length (ms)
+#define SOUND_DURATION_MARGIN 500         // added to the learned length of a sound (ms)
+
 
 #define LED1_BRIGHTNESS 255      // 0-255 led from the front header (big connector)
 #define LED2_BRIGHTNESS 255      // 0-255  
@@ -42,12 +80,14 @@
 // internals
 
 #define MAIN_LOOP_TIME_BASE_MS	5
+#define SENSOR_TRACE_BAUD 115200 // serial speed while recording or replaying a sensor trace, or sending the timeline
+#define IDLE_LOOP_TIME_MS 20     // tick when nothing is going on. Hand and room sensor changes wake up at once
 
 #define HAND_PIN A0            // connect IR hand sensor module to Arduino pin A0
 #define ROOM_PIN A1            // praesense sensor module to Arduino pin A1
 #define SHAKE_PIN A2           // sensor module for tamper detection to Arduino pin A2
 
-#define RNG_SEED_PIN A6        // Used to initialize the randomnes
+#define RNG_SEED_PIN A6        // unconnected, its noise initializes the randomness
 
 #define BUTTON_1 12            // Button for setting the folder
 #define BUTTON_2 A3            // Button for setting the folder
@@ -65,27 +105,72 @@
 #define BIRD_MOTOR2_GND_PIN 3  // D3 
 #define BIRD_MOTOR2_VCC_PIN 4  // D4
 
+#define BEEP_INTERVAL 600      // time between the beeps of the folder selection (ms)
+
+#define BIRD_OUT_TIME 240      // how long motor 1 drives the bird out (ms)
+#define BIRD_IN_TIME 260       // how long motor 2 drives the bird in (ms)
+
 #define DFPLAYER_RX_PIN 10     // D10 -> RX on Arduino TX on DFPlayer
 #define DFPLAYER_TX_PIN 11     // D11 -> TX on Arduino RX on DFPlayer
 
 
 
-#ifdef DEBUG
-  #warning "Serial debugging is enable. This will slow down program flow"
+#ifdef LOG_LEVEL
+  #warning "Logging is enabled. This costs about 150 bytes of RAM"
+#endif
+
+#ifdef DFPLAYER_EMULATOR
+  #warning "DFPlayer emulator is enabled. No sound will be played"
 #endif
 
+#ifdef LOOP_PROFILER
+  #warning "Loop profiler is enabled. This costs about 250 bytes of RAM"
+#endif
+
+#ifdef SENSOR_TRACE_REPLAY
+  #warning "Sensor trace replay is enabled. The sensors are not read"
+#endif
+
+#ifdef TIMELINE
+  #warning "Timeline is enabled. This costs about 150 bytes of RAM"
+#endif
+
+// the loop profiler reads 'p' from the serial port (the replayed trace) and prints text into it (the recorded trace)
+#if (defined(LOG_LEVEL) || defined(TIMELINE) || defined(LOOP_PROFILER)) && (defined(SENSOR_TRACE_RECORD) || defined(SENSOR_TRACE_REPLAY))
+  #error "The log, timeline or loop profiler and the sensor trace can not share the serial port"
+#endif
+
+// job and backoff durations are 16 bit
+#if SOUND_MAX_DURATION > 65535 || SOAP_AMOUNT > 65535 || ROOM_DETECTION_TIMEOUT > 65535 || LED_BLINKING_SPEED > 65535
+  #error "Job durations are limited to 65535 ms"
+#endif
+
+#include "LoopProfiler.h" // after the settings, the profiler macros depend on LOOP_PROFILER
+#include "Log.h"          // after the settings, the log macros depend on LOG_LEVEL
+#include "Timeline.h"     // after the settings, the timeline macros depend on TIMELINE
+
 
 // DFPlayer maintenance timers
-unsigned long lastDFPlayerReset = 0;
-unsigned long lastSoapUse = 0;
+uint32_t lastDFPlayerReset = 0;
+uint32_t lastSoapUse = 0;
 
 // Intervals
-const unsigned long DFPLAYER_RESET_INTERVAL = 10UL * 24UL * 60UL * 60UL * 1000UL; // 10 days
-const unsigned long INACTIVITY_WINDOW = 3UL * 60UL * 60UL * 1000UL;               // 3 hours
-
+const uint32_t DFPLAYER_RESET_INTERVAL = 10UL * 24UL * 60UL * 60UL * 1000UL; // 10 days
+const uint32_t INACTIVITY_WINDOW = 3UL * 60UL * 60UL * 1000UL;               // 3 hours
+
+#if defined(DFPLAYER_EMULATOR)
+DFPlayerEmulator DFPlayerSoftwareSerial;
+#elif defined(DFPLAYER_TIMER_SERIAL)
+TimerSerial DFPlayerSoftwareSerial(DFPLAYER_RX_PIN,DFPLAYER_TX_PIN);// RX, TX
+#else
 SoftwareSerial DFPlayerSoftwareSerial(DFPLAYER_RX_PIN,DFPLAYER_TX_PIN);// RX, TX
+#endif
 DFRobotDFPlayerMini mp3Player;
-SoftTimer mainLoopTimer;
+uint32_t lastTickTime = 0;
+
+// ids of the interrupt captured sensors
+uint8_t handSensor = 0;
+uint8_t roomSensor = 0;
 
 #define FOLDER_STANDARD_BIRD_SOUND 1
 #define FOLDER_SHAKE_SENSOR_ACTIVATED 2
@@ -96,26 +181,26 @@ SoftTimer mainLoopTimer;
 uint8_t maxDetectedFolders = FOLDER_ROOM_END;
 uint8_t folderFileCounts[FOLDER_ROOM_END + 1]; // Index 1-13 used
 uint8_t currentRoomFolder = FOLDER_ROOM_START;
-uint8_t currentRoomFolder_beepCyclePosition = 0;
+uint8_t currentRoomFolder_beepCyclePosition = 0; // beeps left to announce currentRoomFolder, +1 for the final stop
+uint32_t lastBeepTime = 0;
 
 Bounce2::Button button1 = Bounce2::Button();
 Bounce2::Button button2 = Bounce2::Button();
 Bounce2::Button button3 = Bounce2::Button();
 
+// pressed/released of this tick, from the buttons or from a replayed trace
+bool buttonPressed[3];
+bool buttonReleased[3];
+bool replayedButtonPressed[3];
+bool replayedButtonReleased[3];
+
 
-TimeBasedCounter timeBasedCounter(SHAKE_OBSERVATION_WINDOW);
-unsigned long currentTime = 0;
+TimeBasedCounter<COUNTER_SIZE, uint16_t> timeBasedCounter(SHAKE_OBSERVATION_WINDOW); // ms, 16 bit is enough for the window
+ShakeDetector shakeDetector(SHAKE_DECAY_SHIFT, SHAKE_TRIGGER_ENERGY, SHAKE_RELEASE_ENERGY);
+uint32_t currentTime = 0;
 
 void soundOn();
 void soundOff();
-void flapStart();
-void flapEnd();
-void birdOutStart();
-void birdOutEnd();
-void birdInStart();
-void birdInEnd();
-void flapBreakStart();
-void flapBreakEnd();
 void soapOn();
 void soapOff();
 void roomOn();
@@ -126,22 +211,57 @@ void ledOnStart();
 void ledOnEnd();
 void ledOffStart();
 void ledOffEnd();
-void doMp3PlayerSetupStuff();
+void startSdScan(uint16_t startDelay);
+void scanSdCardStep();
+void interruptSdScanForSound();
+bool isFolderAvailable(uint8_t folderId);
+void readButtons();
+void replaySensorEdge(uint8_t sensor, bool active);
+void replayShakeSample(uint16_t sample);
+void startBeepMenu();
+void cancelBeepMenu();
+bool isBeepMenuActive();
+void beepMenuStep();
+#ifdef LOOP_PROFILER
+void profileJobCost(JobManager& job, uint32_t durationUs);
+#endif
+#ifdef TIMELINE
+void timelineJob(JobManager& job, bool started);
+void timelinePin(uint8_t pin, uint8_t level);
+void timelineFrame(bool received, uint8_t command, uint16_t parameter);
+#endif
 
 const uint16_t flapBreakPattern_single[] = {200, 600};
 const uint16_t flapPattern_single[] =        {500};
 
 SoundParams soundParams;
-
-int flapPattern_currentIndex = 0;
-int flapBreakPattern_currentIndex = 0;
-
-JobManager sound(15000, 800, soundOn, soundOff, false, false); //backoff is the safety time for bird termination
-
-JobManager flap(500, flapStart, flapEnd);
-JobManager flapBreak(200, flapBreakStart, flapBreakEnd);
-JobManager birdOut(240, birdOutStart, birdOutEnd);
-JobManager birdIn(260, birdInStart, birdInEnd);
+SpeechFlapGenerator speechFlaps;
+RandomStream fileRandom(1);    // which file of a folder plays
+RandomStream flapRandom(2);    // seeds of the speech-like flapping
+
+// bird out -> flaps and breaks of the pattern (while the sound plays) -> bird in
+const ChoreoStep birdSequence[] PROGMEM = {
+  // pin                 level  duration           condition              elseStep  next
+  {BIRD_MOTOR1_GND_PIN,  HIGH,  0,                 CHOREO_ALWAYS,         0,        1},   // 0: bird out
+  {BIRD_MOTOR1_VCC_PIN,  LOW,   BIRD_OUT_TIME,     CHOREO_ALWAYS,         0,        2},
+  {BIRD_MOTOR1_GND_PIN,  LOW,   0,                 CHOREO_ALWAYS,         0,        3},
+  {BIRD_MOTOR1_VCC_PIN,  HIGH,  0,                 CHOREO_ALWAYS,         0,        4},
+  {CHOREO_NO_PIN,        HIGH,  CHOREO_BREAK_TIME, CHOREO_IF_BREAK_FIRST, 5,        5},   // 4: some patterns start with a break
+  {BIRD_FLAP_PIN,        LOW,   CHOREO_FLAP_TIME,  CHOREO_IF_FLAP_LEFT,   8,        6},   // 5: flap
+  {BIRD_FLAP_PIN,        HIGH,  0,                 CHOREO_ALWAYS,         0,        7},
+  {CHOREO_NO_PIN,        HIGH,  CHOREO_BREAK_TIME, CHOREO_IF_BREAK_LEFT,  8,        5},   // 7: flap break
+  {BIRD_MOTOR2_GND_PIN,  HIGH,  0,                 CHOREO_ALWAYS,         0,        9},   // 8: bird in
+  {BIRD_MOTOR2_VCC_PIN,  LOW,   BIRD_IN_TIME,      CHOREO_ALWAYS,         0,        10},
+  {BIRD_MOTOR2_GND_PIN,  LOW,   0,                 CHOREO_ALWAYS,         0,        11},
+  {BIRD_MOTOR2_VCC_PIN,  HIGH,  0,                 CHOREO_ALWAYS,         0,        CHOREO_END},
+};
+
+// playback measurement for the duration table
+uint8_t playingFolder = 0;
+uint8_t playingFile = 0;
+uint32_t playStartTime = 0;
+
+JobManager sound(SOUND_MAX_DURATION, 800, soundOn, soundOff, false, false); //backoff is the safety time for bird termination
 
 JobManager soap(SOAP_AMOUNT, 2000, soapOn, soapOff, true, true);
 JobManager room(500, ROOM_DETECTION_TIMEOUT, roomOn, roomOff, true, true);
@@ -157,19 +277,17 @@ JobManager ledOff(LED_BLINKING_SPEED, ledOffStart, ledOffEnd);
 
 
 void soapOn() {
-  Serial.println(F("switch soap on"));
+  LOG_INFO(LOG_SOAP_ON, sound.isJobActive());
   digitalWrite(PUMP_PIN, LOW);
 
-  // set new sound params for the sound job
-  Serial.print(sound.isJobActive());
-  Serial.println(F(" = Sound job currently active"));
+  // soap has priority over announcing the room folder
+  cancelBeepMenu();
 
   if(!sound.isJobActive()) {
 
     soundParams.folderId = FOLDER_STANDARD_BIRD_SOUND;
     soundParams.triggerBird = true;
-    Serial.print(F(" setting soundParams.flapBreakPattern. flapBreakPattern_single[0]: "));
-    Serial.println(flapBreakPattern_single[0]);
+    soundParams.speechLikeFlapping = false;
     soundParams.flapBreakPattern = flapBreakPattern_single;
     soundParams.flapPattern = flapPattern_single;
     soundParams.flapBreakPatternSize = 2;
@@ -181,34 +299,45 @@ void soapOn() {
 }
 
 void soapOff() {
-  Serial.println(F("switch soap off"));
+  LOG_INFO(LOG_SOAP_OFF);
   digitalWrite(PUMP_PIN, HIGH);
 }
 
-void roomOn() {
-
-  Serial.println(F("room On"));
+// room or shake sound triggered during the folder beeps, started when they are done
+void (*soundAfterBeepMenu)() = nullptr;
 
+void startRoomSound() {
   if(!sound.isJobActive()) {
-    //execute the chain
-    generateSpeechLikeFlappingPattern(soundParams);
+    //execute the chain. The flap pattern is chosen in soundOn, when the file is known
     soundParams.folderId = currentRoomFolder;
     soundParams.triggerBird = true;
+    soundParams.speechLikeFlapping = true;
 
     sound.startJob();
   }
 }
 
+void roomOn() {
+
+  LOG_INFO(LOG_ROOM_ON);
+
+  if(isBeepMenuActive()) {
+    soundAfterBeepMenu = startRoomSound;
+  } else {
+    startRoomSound();
+  }
+}
+
 void roomOff() {
 }
 
-void shakeOn() {
-  Serial.println(F("shake On"));
+void startShakeSound() {
   if(!sound.isJobActive()) {
 
     // flaps get ignored because trigger bird is false
     soundParams.folderId = FOLDER_SHAKE_SENSOR_ACTIVATED;
     soundParams.triggerBird = false;
+    soundParams.speechLikeFlapping = false;
     soundParams.flapBreakPattern = flapBreakPattern_single;
     soundParams.flapPattern = flapPattern_single;
     soundParams.flapBreakPatternSize = 2;
@@ -219,187 +348,102 @@ void shakeOn() {
   }
 }
 
+void shakeOn() {
+  LOG_INFO(LOG_SHAKE_ON);
+
+  if(isBeepMenuActive()) {
+    soundAfterBeepMenu = startShakeSound;
+  } else {
+    startShakeSound();
+  }
+}
+
 void shakeOff() {
 }
 
 void soundOn() {
+  PROFILE_SCOPE(PROFILE_SOUND_ON);
 
-  Serial.println(F("sound on."));
-  Serial.print(soundParams.folderId);
-  Serial.println(F(" folderId playing"));
+  LOG_INFO(LOG_SOUND_ON, soundParams.folderId);
 
   
+  if(!isFolderAvailable(soundParams.folderId)) {
+    LOG_ERROR(LOG_FOLDER_NOT_SCANNED, soundParams.folderId);
+    sound.endJob();
+    return;
+  }
+  interruptSdScanForSound();
+
   int count = folderFileCounts[soundParams.folderId];
-  uint8_t fileNum = random(1, count + 1);
-  Serial.print(F("Playing file "));
-  Serial.print(fileNum);
-  Serial.print(F(" from folder "));
-  Serial.println(soundParams.folderId);
+  uint8_t fileNum = fileRandom.between(1, count);
+  LOG_INFO(LOG_PLAY_FILE, fileNum, soundParams.folderId);
   mp3Player.playFolder(soundParams.folderId, fileNum);
 
+  playingFolder = soundParams.folderId;
+  playingFile = fileNum;
+  playStartTime = millis();
+
+  // the sound job ends with "play finished". As safety it times out after the learned length of the file
+  // (or SOUND_MAX_DURATION if the file was never played to the end before)
+  uint16_t learnedDuration = getFileDuration(playingFolder, playingFile);
+  LOG_DEBUG(LOG_LEARNED_DURATION, learnedDuration);
+  sound.setNewDurationTime(learnedDuration ? learnedDuration + SOUND_DURATION_MARGIN : SOUND_MAX_DURATION);
+
   if(soundParams.triggerBird) {
-    Serial.println(F("Sound doing Birdstuff"));
+    LOG_INFO(LOG_BIRD_OUT);
 
-    // 15 Seconds max sound lengh for safety
-    // some other routine should test if mp3 is still playing and  stop sound job (and therefore pull in bird)
-    sound.setNewDurationTime(15000);
     sound.restartJobTimer();
 
-    flapPattern_currentIndex = 0;
-    flapBreakPattern_currentIndex = 0;
+    // the lip sync table of the file if there is one (FlapTables.h). Otherwise speech-like flapping
+    // or the pattern of the job
+    if(!selectFlapTable(soundParams, playingFolder, playingFile, learnedDuration) && soundParams.speechLikeFlapping) {
+      // flap as long as the sound plays once the bird is out (default length if unknown)
+      uint16_t flapDuration = learnedDuration > BIRD_OUT_TIME ? learnedDuration - BIRD_OUT_TIME : 0;
+      speechFlaps.begin(flapDuration, flapRandom.next());
+      soundParams.flapGenerator = &speechFlaps;
+    }
 
     //execute the bird chain
-    birdOut.startJob();
+    startChoreography(birdSequence, soundParams);
   }
 
 }
 
 void soundOff() {
+  // no more flaps, the bird goes in
+  finishChoreography();
 }
 
-void birdOutStart() {
-  Serial.println(F("Bird out start"));
-  digitalWrite(BIRD_MOTOR1_GND_PIN, HIGH);
-  digitalWrite(BIRD_MOTOR1_VCC_PIN, LOW);
-}
-
-void birdOutEnd() {
-  Serial.println(F("Bird out end"));
-  digitalWrite(BIRD_MOTOR1_GND_PIN, LOW);
-  digitalWrite(BIRD_MOTOR1_VCC_PIN, HIGH);
-  
-  //execute the chain
-  if(soundParams.flapBreakPatternSize > soundParams.flapPatternSize) {
-    flapBreak.startJob();
-  } else {
-    flap.startJob();
-  }
-
-}
-
-void birdInStart() {
-  Serial.println(F("Bird in start"));
-  digitalWrite(BIRD_MOTOR2_GND_PIN, HIGH);
-  digitalWrite(BIRD_MOTOR2_VCC_PIN, LOW);
-
-}
-
-void birdInEnd() {
-  Serial.println(F("Bird in end"));
-  digitalWrite(BIRD_MOTOR2_GND_PIN, LOW);
-  digitalWrite(BIRD_MOTOR2_VCC_PIN, HIGH);
-}
-
-
 // ========================================================================================================================
-
-void flapStart() {
-  Serial.print(F("flap Start"));
-  Serial.println(soundParams.flapPattern[flapPattern_currentIndex]);
-
-  digitalWrite(BIRD_FLAP_PIN, LOW);
-
-  flap.setNewDurationTime(soundParams.flapPattern[flapPattern_currentIndex]);
-  flap.restartJobTimer();
-}
-
-void flapEnd() {
-  Serial.println(F("flap End"));
-  digitalWrite(BIRD_FLAP_PIN, HIGH);
-
-  flapPattern_currentIndex = flapPattern_currentIndex + 1;
-
-  //check flap break possible
-  if(flapBreakPattern_currentIndex < soundParams.flapBreakPatternSize && sound.isJobActive()) {
-    flapBreak.startJob();
-  } else {
-    //no flap break anymore (or sound got ended). Do now bird in
-    birdIn.startJob();
-  }
-
-}
-
-void flapBreakStart(){
-  Serial.print(F("flapBreakStart "));
-  Serial.println(soundParams.flapBreakPattern[flapBreakPattern_currentIndex]);
-
-  flapBreak.setNewDurationTime(soundParams.flapBreakPattern[flapBreakPattern_currentIndex]);
-  flapBreak.restartJobTimer();
-
-}
-
-void flapBreakEnd() {
-  Serial.println(F("flapBreakEnd"));
-
-  flapBreakPattern_currentIndex = flapBreakPattern_currentIndex + 1;
-
-
-  //check flap possible
-  if(flapPattern_currentIndex < soundParams.flapPatternSize && sound.isJobActive()) {
-    flap.startJob();
-  } else {
-    //no flap anymore (or sound got ended). Do now bird in
-    birdIn.startJob();
-  }
-
-}
-
-// ========================================================================================================================
-void printDetail(uint8_t type, int value){
+void logDFPlayerEvent(uint8_t type, int value){
+  (void)value; // only used by the log, unused without LOG_LEVEL
   switch (type) {
     case TimeOut:
-      Serial.println(F("DFPLAYER: Time Out!"));
+      LOG_ERROR(LOG_DFPLAYER_TIMEOUT);
       break;
     case WrongStack:
-      Serial.println(F("DFPLAYER: Stack Wrong!"));
+      LOG_ERROR(LOG_DFPLAYER_WRONG_STACK);
       break;
     case DFPlayerCardInserted:
-      Serial.println(F("DFPLAYER: Card Inserted!"));
+      LOG_INFO(LOG_DFPLAYER_CARD_INSERTED);
       break;
     case DFPlayerCardRemoved:
-      Serial.println(F("DFPLAYER: Card Removed!"));
+      LOG_INFO(LOG_DFPLAYER_CARD_REMOVED);
       break;
     case DFPlayerCardOnline:
-      Serial.println(F("DFPLAYER: Card Online!"));
+      LOG_INFO(LOG_DFPLAYER_CARD_ONLINE);
       break;
     case DFPlayerUSBInserted:
-      Serial.println(F("DFPLAYER: USB Inserted!"));
+      LOG_INFO(LOG_DFPLAYER_USB_INSERTED);
       break;
     case DFPlayerUSBRemoved:
-      Serial.println(F("DFPLAYER: USB Removed!"));
+      LOG_INFO(LOG_DFPLAYER_USB_REMOVED);
       break;
     case DFPlayerPlayFinished:
-      Serial.print(F("DFPLAYER: Number: "));
-      Serial.print(value);
-      Serial.println(F(" Play Finished!"));
+      LOG_INFO(LOG_DFPLAYER_NUMBER_FINISHED, value);
       break;
     case DFPlayerError:
-      Serial.print(F("DFPLAYER: DFPlayerError:"));
-      switch (value) {
-        case Busy:
-          Serial.println(F("DFPLAYER: Card not found"));
-          break;
-        case Sleeping:
-          Serial.println(F("DFPLAYER: Sleeping"));
-          break;
-        case SerialWrongStack:
-          Serial.println(F("DFPLAYER: Get Wrong Stack"));
-          break;
-        case CheckSumNotMatch:
-          Serial.println(F("DFPLAYER: Check Sum Not Match"));
-          break;
-        case FileIndexOut:
-          Serial.println(F("DFPLAYER: File Index Out of Bound"));
-          break;
-        case FileMismatch:
-          Serial.println(F("DFPLAYER: Cannot Find File"));
-          break;
-        case Advertise:
-          Serial.println(F("DFPLAYER: In Advertise"));
-          break;
-        default:
-          break;
-      }
+      LOG_ERROR(LOG_DFPLAYER_ERROR, value);
       break;
     default:
       break;
@@ -407,11 +451,12 @@ void printDetail(uint8_t type, int value){
 }
 
 void setup() {
-  mainLoopTimer.setTimeOutTime(MAIN_LOOP_TIME_BASE_MS);
-  mainLoopTimer.reset();
-
   pinMode(HAND_PIN, INPUT_PULLUP);
   pinMode(ROOM_PIN, INPUT_PULLUP);
+  watchIdleWakePin(HAND_PIN);
+  watchIdleWakePin(ROOM_PIN);
+  handSensor = captureSensorPin(HAND_PIN, true);
+  roomSensor = captureSensorPin(ROOM_PIN, false);
   pinMode(SHAKE_PIN, INPUT);
 
   pinMode(LED_BUILTIN, OUTPUT);
@@ -445,155 +490,489 @@ void setup() {
   button3.setPressedState( LOW );
 
 
-  #ifdef DEBUG
+  #if defined(SENSOR_TRACE_RECORD) || defined(SENSOR_TRACE_REPLAY) || defined(TIMELINE)
+    Serial.begin(SENSOR_TRACE_BAUD);
+  #elif defined(LOG_LEVEL) || defined(LOOP_PROFILER)
     Serial.begin(9600);
   #endif
 
-  int seed = analogRead(RNG_SEED_PIN);
+  //initialize randomness so it is not every time the same (before the shake sampling takes the ADC)
+  beginEntropy(RNG_SEED_PIN);
+
+#ifdef SENSOR_TRACE_REPLAY
+  // the sensors come from the recorded trace
+  beginTraceReplay(Serial, replaySensorEdge, replayShakeSample);
+#else
+  beginSensorCapture();
+  // from now on the ADC samples the shake sensor in the background (no more analogRead)
+  beginShakeSampling(SHAKE_PIN, shakeDetector);
+#endif
 
-  Serial.print(F("seed is: "));
-  Serial.println(seed);
+#ifdef SENSOR_TRACE_RECORD
+  setShakeSampleTap(traceShakeSample);
+  beginTraceRecording(Serial);
+  // the replay starts with all sensors inactive
+  traceEdge(TRACE_HAND, isSensorActive(handSensor), millis());
+  traceEdge(TRACE_ROOM, isSensorActive(roomSensor), millis());
+#endif
 
-  //initialize randomness so it is not every time the same
-  randomSeed(seed);
+#ifdef LOOP_PROFILER
+  JobManager::setJobCostHook(profileJobCost);
+#endif
+
+#ifdef TIMELINE
+  JobManager::setJobHook(timelineJob);
+  setChoreographyPinTap(timelinePin);
+  mp3Player.setFrameTap(timelineFrame);
+#endif
 
 
 
   //mp3 player stuff
+#ifdef DFPLAYER_EMULATOR
+  // same card as in the resources folder
+  DFPlayerSoftwareSerial.setFolder(FOLDER_STANDARD_BIRD_SOUND, 1, 1200);
+  DFPlayerSoftwareSerial.setFolder(FOLDER_SHAKE_SENSOR_ACTIVATED, 1, 1360);
+  DFPlayerSoftwareSerial.setFolder(FOLDER_BEEP, 1, 170);
+  DFPlayerSoftwareSerial.setFolder(FOLDER_ROOM_START, 7, 2800);
+#endif
   DFPlayerSoftwareSerial.begin(9600); // DFPlayer Mini mit SoftwareSerial initialisieren
   bool mp3PlayerOnline = mp3Player.begin(DFPlayerSoftwareSerial, true, true);
   
   if(mp3PlayerOnline) {
-    doMp3PlayerSetupStuff();
+    // runs in the background, see scanSdCardStep()
+    startSdScan(0);
   }
 
 
   ledOn.startJob();
 }
 
-void doMp3PlayerSetupStuff() {
+// ========================================================================================================================
+// SD card catalog scanner
+// Resumable version of the folder and file detection (see folderStructure.MD). loop() advances it by one step per tick,
+// so the sensors and the pump work while the card is scanned. A folder can be played as soon as its file count settled.
+
+enum SdScanState : uint8_t {
+  SCAN_IDLE,          // catalog complete, nothing to do
+  SCAN_FINGERPRINT,   // read the total file count until stable
+  SCAN_FOLDER_COUNT,  // read the folder count until stable, then try the catalog stored in the EEPROM
+  SCAN_FOLDER_PLAY,   // play the first file of the current folder (needed for a correct file count)
+  SCAN_FILE_COUNT,    // read the file count of the current folder until stable
+  SCAN_FINISH         // stop playback, restore the volume and store the catalog
+};
+
+SdScanState scanState = SCAN_IDLE;
+uint8_t scanFolder = 0;             // folder currently scanned
+uint8_t scannedFolders = 0;         // folders 1..scannedFolders have a settled file count
+int scanTotalFiles = -1;            // fingerprint of the card, with scanReportedFolders
+int scanReportedFolders = -1;
+int scanLastValue = INT16_MAX;
+uint8_t scanConsecutiveSame = 0;
+uint8_t scanAttempts = 0;
+bool scanQueryPending = false;
+bool scanFileDetection = false;
+bool scanMuted = false;
+uint32_t scanWaitStart = 0;
+uint16_t scanWaitTime = 0;
+
+void scanQueryAnswered(uint8_t /* command */, int value) {
+  scanQueryPending = false;
+  scanAttempts += 1;
+
+  LOG_DEBUG(LOG_SCAN_READ, value);
+
+  if(scanLastValue == value) {
+    scanConsecutiveSame += 1;
+  } else {
+    scanConsecutiveSame = 0;
+    scanLastValue = value;
+  }
+}
+
+void scanResetConvergence() {
+  scanLastValue = INT16_MAX;
+  scanConsecutiveSame = 0;
+  scanAttempts = 0;
+}
+
+void scanWait(uint16_t waitTime) {
+  scanWaitStart = millis();
+  scanWaitTime = waitTime;
+}
+
+// (Re)start the scan. startDelay gives the DFPlayer time to read a freshly inserted card
+void startSdScan(uint16_t startDelay) {
+  LOG_INFO(LOG_SCAN_STARTED);
   mp3Player.setTimeOut(2000);
-  mp3Player.volume(0);
-  delay(50);
+  scanResetConvergence();
+  scannedFolders = 0;
+  scanTotalFiles = -1;
+  scanReportedFolders = -1;
+  scanState = SCAN_FINGERPRINT;
+  scanWait(startDelay);
+}
 
-  int consecutiveSame = 0;
-  int lastValue = INT16_MAX;
-  int currentRead;
-  bool filedetection = false;
+// both counts were read consistently. Cards with the same number of files differ in the folder count
+bool hasSdFingerprint() {
+  return scanTotalFiles > 0 && scanReportedFolders >= 0 && scanReportedFolders <= UINT8_MAX;
+}
 
+bool isSdScanActive() {
+  return scanState != SCAN_IDLE;
+}
 
-  while(consecutiveSame < 4) {
-    Serial.print(F("consecutiveSame: "));
-    Serial.println(consecutiveSame);
-    currentRead = mp3Player.readFolderCounts();
+bool isFolderAvailable(uint8_t folderId) {
+  return !isSdScanActive() || folderId <= scannedFolders;
+}
 
-    if(mp3Player.available() ) {
-        uint8_t type = mp3Player.readType();
-        int value = mp3Player.read();
-        printDetail(type, value);
-    }
-    Serial.print(F("currentRead: "));
-    Serial.println(currentRead);
-    if(lastValue == currentRead){
-      consecutiveSame += 1;
-    } else {
-      consecutiveSame = 0;
-      lastValue = currentRead;
-    }
+// scan progress in percent
+uint8_t sdScanProgress() {
+  if(!isSdScanActive()) {
+    return 100;
   }
+  if(scanState == SCAN_FINGERPRINT || scanState == SCAN_FOLDER_COUNT || maxDetectedFolders == 0) {
+    return 0;
+  }
+  return (uint16_t)scannedFolders * 100 / maxDetectedFolders;
+}
 
-  maxDetectedFolders = lastValue;
-  Serial.print(F("maxDetectedFolders after readFolderCounts "));
-  Serial.println(maxDetectedFolders);
+// a sound is about to be played: make it audible and redo the file count of the interrupted folder afterwards
+void interruptSdScanForSound() {
+  if(scanMuted) {
+    mp3Player.volume(VOLUME);
+    scanMuted = false;
+  }
+  if(scanState == SCAN_FILE_COUNT) {
+    scanState = SCAN_FOLDER_PLAY;
+  }
+}
 
-  if(maxDetectedFolders > FOLDER_ROOM_END || maxDetectedFolders < 0) {
+// the end of the scan, also for a catalog loaded from the EEPROM: the DFPlayer comes out of its reset at full volume
+void endSdScan() {
+  mp3Player.volume(VOLUME);
+  scanMuted = false;
+  mp3Player.setTimeOut(1000);
+  LOG_INFO(LOG_SCAN_FINISHED);
+  scanState = SCAN_IDLE;
+}
 
-    Serial.print(F("Getting folder count is not supported or errornous. Falling back to file detection "));
-    filedetection = true;
+void scanSdCardStep() {
+  if(scanState == SCAN_IDLE || scanQueryPending || millis() - scanWaitStart < scanWaitTime) {
+    return;
+  }
 
-    maxDetectedFolders = FOLDER_ROOM_END; //setting temporary for iterating over folders (this is not good code, I know, sry)
+  // sounds and the folder beeps have priority. The scan continues when they are done, with the
+  // file count of the current folder from the start (see interruptSdScanForSound())
+  if(sound.isJobActive() || isBeepMenuActive()) {
+    return;
   }
 
-  for (int i = 1; i <= maxDetectedFolders; i++) {
-    mp3Player.playFolder(i, 1);
-    delay(100);
+  switch(scanState) {
+    case SCAN_FINGERPRINT:
+      if(scanConsecutiveSame < 2 && scanAttempts < 10) {
+        scanQueryPending = mp3Player.queryFileCounts(scanQueryAnswered);
+        return;
+      }
+
+      // on failure we simply do a full scan
+      scanTotalFiles = (scanConsecutiveSame >= 2) ? scanLastValue : -1;
+      LOG_INFO(LOG_SCAN_TOTAL_FILES, scanTotalFiles);
+
+      scanResetConvergence();
+      scanState = SCAN_FOLDER_COUNT;
+      scanWait(50);
+      break;
 
-    lastValue = INT16_MAX;
-    consecutiveSame = 0;
-    while(consecutiveSame < 6) {
-      Serial.print(F("consecutiveSame: "));
-      Serial.println(consecutiveSame);
-      currentRead = mp3Player.readFileCountsInFolder(i);
-      
-      if(mp3Player.available() ) {
-        uint8_t type = mp3Player.readType();
-        int value = mp3Player.read();
-        printDetail(type, value);
+    case SCAN_FOLDER_COUNT:
+      if(scanConsecutiveSame < 4) {
+        scanQueryPending = mp3Player.queryFolderCounts(scanQueryAnswered);
+        return;
       }
 
-      delay(50);
-      Serial.print(F("currentRead: "));
-      Serial.println(currentRead);
-      if(lastValue == currentRead){
-        consecutiveSame += 1;
+      scanReportedFolders = scanLastValue;
+      if(hasSdFingerprint() && loadSdCatalog(scanTotalFiles, scanReportedFolders, maxDetectedFolders, folderFileCounts, sizeof(folderFileCounts))) {
+        LOG_INFO(LOG_SCAN_CATALOG_LOADED, maxDetectedFolders);
+        scannedFolders = maxDetectedFolders;
+        endSdScan();
+        return;
+      }
+
+      scanFileDetection = false;
+      if(scanLastValue > FOLDER_ROOM_END || scanLastValue < 0) {
+        LOG_ERROR(LOG_SCAN_NO_FOLDER_COUNT);
+        scanFileDetection = true;
+        maxDetectedFolders = FOLDER_ROOM_END; //iterate over all folders, corrected in SCAN_FINISH
       } else {
-        consecutiveSame = 0;
-        lastValue = currentRead;
+        maxDetectedFolders = scanLastValue;
       }
-    }
+      LOG_INFO(LOG_SCAN_FOLDERS, maxDetectedFolders);
+
+      scanFolder = 1;
+      scanState = (maxDetectedFolders > 0) ? SCAN_FOLDER_PLAY : SCAN_FINISH;
+      break;
+
+    case SCAN_FOLDER_PLAY:
+      if(!scanMuted) {
+        // the first folder, or a sound interrupted the scan
+        mp3Player.volume(0);
+        scanMuted = true;
+      }
+      mp3Player.playFolder(scanFolder, 1);
+      scanResetConvergence();
+      scanState = SCAN_FILE_COUNT;
+      scanWait(100);
+      break;
 
-    // mp3Player.playFolder(i, lastValue);
-    // delay(100);
-    // currentRead = mp3Player.readFileCountsInFolder(i);
-    // Serial.print(F("lastValue currentRead: "));
-    // Serial.println(currentRead);
+    case SCAN_FILE_COUNT:
+      if(scanConsecutiveSame < 6) {
+        scanQueryPending = mp3Player.queryFileCountsInFolder(scanFolder, scanQueryAnswered);
+        scanWait(50);
+        return;
+      }
+
+      folderFileCounts[scanFolder] = scanLastValue;
+      scannedFolders = scanFolder;
+
+      LOG_INFO(LOG_SCAN_FOLDER_FILES, scanFolder, scanLastValue);
+      LOG_INFO(LOG_SCAN_PROGRESS, sdScanProgress());
+
+      if(scanLastValue == 0 || scanLastValue == -1) {
+        LOG_ERROR(LOG_SCAN_EMPTY_FOLDER);
+        scanState = SCAN_FINISH;
+      } else if(scanFolder >= maxDetectedFolders) {
+        scanState = SCAN_FINISH;
+      } else {
+        scanFolder += 1;
+        scanState = SCAN_FOLDER_PLAY;
+      }
+      break;
 
-    folderFileCounts[i] = lastValue;
+    case SCAN_FINISH:
+      if(scanFileDetection) {
+        LOG_INFO(LOG_SCAN_FILE_DETECTION);
+        maxDetectedFolders = 0;
+
+        for(int i = 1; i <= FOLDER_ROOM_END; i++) {
+          if(folderFileCounts[i] > 0 && folderFileCounts[i] < 255) {
+            maxDetectedFolders = maxDetectedFolders + 1;
+          } else {
+            //abort when there is a folder detected with 0 files
+            break;
+          }
+        }
+
+        LOG_INFO(LOG_SCAN_DETECTED_FOLDERS, maxDetectedFolders);
+      }
 
-    Serial.print(F("folderFileCounts[i] i: "));
-    Serial.print(i);
-    Serial.print(F(" folderFileCounts: "));
-    Serial.println(lastValue);
+      mp3Player.stop();
 
-    if(lastValue == 0) {
-      Serial.println(F("Found a Folder with 0 files. Aborting... "));
+      // with a valid fingerprint the catalog in the EEPROM did not match: a different card, its files need to be
+      // measured again. Without one the card is unknown, a flaky read of the same card must not lose the durations
+      if(hasSdFingerprint()) {
+        storeSdCatalog(scanTotalFiles, scanReportedFolders, maxDetectedFolders, folderFileCounts, sizeof(folderFileCounts));
+        clearFileDurations();
+      }
+      endSdScan();
       break;
-    } else if (lastValue == -1) {
-      Serial.println(F("Found a Folder with -1 files. Aborting... "));
+
+    default:
       break;
-    }
   }
+}
+
+// ========================================================================================================================
+// Folder selection beeps: one beep per room folder up to currentRoomFolder. Runs alongside the rest of the loop.
 
+// a new button press restarts the beeps for the new folder
+void startBeepMenu() {
+  currentRoomFolder_beepCyclePosition = currentRoomFolder - FOLDER_ROOM_START + 2;
+  lastBeepTime = millis() - BEEP_INTERVAL; // first beep right away
+}
 
-  if(filedetection) {
-    Serial.println(F("Filedetection is active."));
-    maxDetectedFolders = 0;
+// the sound that cancels the menu replaces a waiting room or shake sound as well
+void cancelBeepMenu() {
+  currentRoomFolder_beepCyclePosition = 0;
+  soundAfterBeepMenu = nullptr;
+}
 
-    for(int i = 1; i <= FOLDER_ROOM_END; i++) {
-      if(folderFileCounts[i] > 0 && folderFileCounts[i] < 255) {
-        maxDetectedFolders = maxDetectedFolders + 1;
-      } else {
-        //abort when there is a folder detected with 0 files
-        break;
-      }
+bool isBeepMenuActive() {
+  return currentRoomFolder_beepCyclePosition > 0;
+}
+
+void beepMenuStep() {
+  if(!isBeepMenuActive() || millis() - lastBeepTime < BEEP_INTERVAL) {
+    return;
+  }
+  lastBeepTime = millis();
+  currentRoomFolder_beepCyclePosition -= 1;
+
+  if(currentRoomFolder_beepCyclePosition > 0) {
+    interruptSdScanForSound();
+    mp3Player.playFolder(FOLDER_BEEP, 1);
+  } else {
+    // the last beep had its time to play
+    mp3Player.stop();
+    if(soundAfterBeepMenu) {
+      TIMELINE_RESUME(soundAfterBeepMenu == startRoomSound ? TRACK_ROOM : TRACK_SHAKE);
+      soundAfterBeepMenu();
+      soundAfterBeepMenu = nullptr;
     }
+  }
+}
 
-    Serial.print(F("Detected files in the first X folders: "));
-    Serial.println(maxDetectedFolders);
+// ========================================================================================================================
+// Sensor trace (see SensorTrace.h)
 
-    if(maxDetectedFolders > FOLDER_ROOM_END) {
-      //safety
-      maxDetectedFolders = FOLDER_ROOM_END;
-      Serial.println(F("Safety for filedetection activated"));
+void readButtons() {
+#ifndef SENSOR_TRACE_REPLAY
+  Bounce2::Button* buttons[] = {&button1, &button2, &button3};
+#endif
+  for(uint8_t i = 0; i < 3; i++) {
+#ifdef SENSOR_TRACE_REPLAY
+    buttonPressed[i] = replayedButtonPressed[i];
+    buttonReleased[i] = replayedButtonReleased[i];
+    replayedButtonPressed[i] = false;
+    replayedButtonReleased[i] = false;
+#else
+    buttons[i]->update();
+    buttonPressed[i] = buttons[i]->pressed();
+    buttonReleased[i] = buttons[i]->released();
+#endif
+
+#ifdef SENSOR_TRACE_RECORD
+    if(buttonPressed[i] || buttonReleased[i]) {
+      traceEdge(TRACE_BUTTON1 + i, buttonPressed[i], currentTime);
+    }
+#endif
+    if(buttonPressed[i] || buttonReleased[i]) {
+      TIMELINE_EDGE(TRACK_BUTTON1 + i, buttonPressed[i], currentTime);
     }
   }
+}
 
+void replaySensorEdge(uint8_t sensor, bool active) {
+  if(sensor == TRACE_HAND) {
+    injectSensorLevel(handSensor, active);
+  } else if(sensor == TRACE_ROOM) {
+    injectSensorLevel(roomSensor, active);
+  } else if(sensor <= TRACE_BUTTON3) {
+    if(active) {
+      replayedButtonPressed[sensor - TRACE_BUTTON1] = true;
+    } else {
+      replayedButtonReleased[sensor - TRACE_BUTTON1] = true;
+    }
+  }
+}
 
-  mp3Player.stop();
-  delay(500);
+void replayShakeSample(uint16_t sample) {
+  shakeDetector.addSample(sample);
+}
 
-  mp3Player.volume(VOLUME);
-  mp3Player.setTimeOut(1000);
+// ========================================================================================================================
+// Loop profiler (see LoopProfiler.h): the cost of the callbacks of each job
+
+#ifdef LOOP_PROFILER
+void profileJobCost(JobManager& job, uint32_t durationUs) {
+  uint8_t jobId;
+  if(&job == &sound) {
+    jobId = PROFILE_JOB_SOUND;
+  } else if(&job == &soap) {
+    jobId = PROFILE_JOB_SOAP;
+  } else if(&job == &room) {
+    jobId = PROFILE_JOB_ROOM;
+  } else if(&job == &shake) {
+    jobId = PROFILE_JOB_SHAKE;
+  } else {
+    jobId = PROFILE_JOB_LED;
+  }
+  profileJob(jobId, durationUs);
+}
+#endif
+
+// ========================================================================================================================
+// Timeline (see Timeline.h). The bird and the DFPlayer continue the trigger of the sound that moves them.
+
+#ifdef TIMELINE
+void timelineJob(JobManager& job, bool started) {
+  uint8_t track;
+  if(&job == &soap) {
+    track = TRACK_SOAP;
+  } else if(&job == &room) {
+    track = TRACK_ROOM_JOB;
+  } else if(&job == &shake) {
+    track = TRACK_SHAKE_JOB;
+  } else if(&job == &sound) {
+    track = TRACK_SOUND;
+  } else {
+    return; // LED blinking
+  }
+
+  if(started) {
+    timelineBegin(track, track == TRACK_SOUND ? soundParams.folderId : 0);
+  } else {
+    timelineEnd(track);
+  }
+}
+
+// all bird pins are active low
+void timelinePin(uint8_t pin, uint8_t level) {
+  uint8_t track;
+  if(pin == BIRD_MOTOR1_VCC_PIN) {
+    track = TRACK_BIRD_OUT;
+  } else if(pin == BIRD_FLAP_PIN) {
+    track = TRACK_FLAP;
+  } else if(pin == BIRD_MOTOR2_VCC_PIN) {
+    track = TRACK_BIRD_IN;
+  } else {
+    return;
+  }
+
+  timelineResume(TRACK_SOUND);
+  if(level == LOW) {
+    timelineBegin(track);
+  } else {
+    timelineEnd(track);
+  }
+}
+
+// a received frame answers the last sent one
+void timelineFrame(bool received, uint8_t command, uint16_t parameter) {
+  int16_t arg = (int16_t)((uint16_t)command << 8 | (parameter & 0xFF));
+  if(received) {
+    timelineResume(TRACK_DFPLAYER_SENT);
+    timelineInstant(TRACK_DFPLAYER_RECEIVED, arg);
+  } else {
+    timelineInstant(TRACK_DFPLAYER_SENT, arg);
+  }
+}
+#endif
+
+// ========================================================================================================================
+// Idle: no soap, sound, bird or beeps and no DFPlayer traffic. Backoffs may be pending, their deadlines are kept.
+
+bool isUnitIdle() {
+  return !soap.isJobActive() && !room.isJobActive() && !shake.isJobActive() && !sound.isJobActive()
+      && !isChoreographyActive() && !isBeepMenuActive() && !isSdScanActive()
+      && mp3Player.pendingCommands() == 0 && mp3Player.pendingQueries() == 0;
+}
+
+// sleeps until the next tick, or the next job deadline or bird step if that comes earlier
+void waitForNextTick() {
+  uint32_t wakeTime = lastTickTime + (isUnitIdle() ? IDLE_LOOP_TIME_MS : MAIN_LOOP_TIME_BASE_MS);
+  uint32_t deadline;
+  if(JobManager::nextDeadline(deadline) && (int32_t)(deadline - wakeTime) < 0) {
+    wakeTime = deadline;
+  }
+  if(choreographyNextDeadline(deadline) && (int32_t)(deadline - wakeTime) < 0) {
+    wakeTime = deadline;
+  }
+
+  // the serial buffer takes what fits, the rest waits for the next tick
+  LOG_FLUSH(Serial);
+  TIMELINE_FLUSH(Serial);
+  sleepUntil(wakeTime);
+  lastTickTime = millis();
 }
 
 void reinitializeDFPlayerSerial() {
@@ -609,9 +988,8 @@ void reinitializeDFPlayerSerial() {
 
   bool ok = mp3Player.begin(DFPlayerSoftwareSerial, true, true);
 
-  Serial.println(F("Reinitialized MP3 Player"));
+  LOG_INFO(LOG_DFPLAYER_REINIT_DONE, ok);
   if (ok) {
-  Serial.println(F("initialization was ok"));
     mp3Player.volume(VOLUME);
   }
   
@@ -619,39 +997,77 @@ void reinitializeDFPlayerSerial() {
 
 
 void loop() {
-  while(!mainLoopTimer.hasTimedOut());
-  mainLoopTimer.reset();
+#ifdef LOOP_PROFILER
+  if(Serial.available() && Serial.read() == 'p') {
+    profileDump();
+    Serial.print(F("idle "));
+    Serial.print(idlePercent());
+    Serial.println(F(" %"));
+    Serial.print(F("bird steps late at most "));
+    Serial.print(choreographyMaxLateness());
+    Serial.println(F(" ms"));
+    profileReset();
+    resetIdleStatistics();
+    resetChoreographyMaxLateness();
+  }
+#endif
+
+  waitForNextTick();
+  PROFILE_TICK();
+  TIMELINE_NO_CAUSE();
+  PROFILE_SCOPE(PROFILE_TICK);
   
   currentTime = millis();
 
+#ifdef SENSOR_TRACE_REPLAY
+  replayTrace();
+#endif
+
+  // ADC noise and the wake up jitter of the tick, over the first seconds
+  addEntropy(shakeDetector.latestSample());
+
   // Sensor-Zustand überprüfen
-  bool handSensor_isOn = !digitalRead(HAND_PIN);
-  bool roomSensor_isOn = digitalRead(ROOM_PIN);
-  uint16_t shakeSensor_value = analogRead(SHAKE_PIN);
+  // the sensors are captured by an interrupt. A short activation between two ticks counts as well
+  bool handSensor_isOn = isSensorActive(handSensor);
+  bool roomSensor_isOn = isSensorActive(roomSensor);
+  SensorEvent sensorEvent;
+  while(readSensorEvent(sensorEvent)) {
+#ifdef SENSOR_TRACE_RECORD
+    traceEdge(sensorEvent.sensor == handSensor ? TRACE_HAND : TRACE_ROOM, sensorEvent.active, sensorEvent.time);
+#endif
+    TIMELINE_EDGE(sensorEvent.sensor == handSensor ? TRACK_HAND : TRACK_ROOM, sensorEvent.active, sensorEvent.time);
+    if(sensorEvent.active && sensorEvent.sensor == handSensor) {
+      handSensor_isOn = true;
+    } else if(sensorEvent.active && sensorEvent.sensor == roomSensor) {
+      roomSensor_isOn = true;
+    }
+  }
 
   //display sensor1 state with buldin led
   digitalWrite(LED_BUILTIN, handSensor_isOn);
 
-  button1.update();
-  button2.update();
-  button3.update();
+  readButtons();
+
+#ifdef SENSOR_TRACE_RECORD
+  flushTrace();
+#endif
+
+  // ends all jobs and backoff periods that are due
+  PROFILE_BEGIN(PROFILE_JOBS);
+  JobManager::handleDueJobs();
+  PROFILE_END(PROFILE_JOBS);
 
-  soap.handleJob();
-  room.handleJob();
-  shake.handleJob();
-  sound.handleJob();
-  birdOut.handleJob();
-  birdIn.handleJob();
-  flap.handleJob();
-  flapBreak.handleJob();
-  ledOn.handleJob();
-  ledOff.handleJob();
+  PROFILE_BEGIN(PROFILE_CHOREOGRAPHY);
+  updateChoreography();
+  PROFILE_END(PROFILE_CHOREOGRAPHY);
 
 
   //--------------------------------------
   // sound observation loop
+  // drain all queued events, several frames can arrive between two ticks
 
-  if(mp3Player.available() ) {
+  PROFILE_BEGIN(PROFILE_DFPLAYER);
+  while(mp3Player.available()) {
 
     uint8_t type = mp3Player.readType();
     int value = mp3Player.read();
@@ -659,27 +1075,41 @@ void loop() {
 
     if (sound.isJobActive() && type == DFPlayerPlayFinished) {
     //sound is done playing. Terminate Bird.
-      Serial.print(F("DFPLAYER: Finished playing filenumber "));
-      Serial.println(value);
+      LOG_INFO(LOG_PLAY_FINISHED, value);
+      learnFileDuration(playingFolder, playingFile, millis() - playStartTime);
       mp3Player.stop();
       sound.endJob(); //terminates bird
     } else {
-      printDetail(type, value); //Print the detail message from DFPlayer to handle different errors and states.
+      if (type == DFPlayerCardInserted) {
+        // new card. The scan is skipped again if it matches the catalog in the EEPROM
+        startSdScan(1500);
+      }
+      logDFPlayerEvent(type, value);
     }
   }
 
+  PROFILE_END(PROFILE_DFPLAYER);
+
+  PROFILE_BEGIN(PROFILE_SD_SCAN);
+  TIMELINE_NO_CAUSE(); // the bird and the DFPlayer may have continued a trigger, the scan belongs to none
+  scanSdCardStep();
+  PROFILE_END(PROFILE_SD_SCAN);
+
 
   //--------------------------------------
   if (handSensor_isOn) {
+    TIMELINE_RESUME(TRACK_HAND);
     soap.startJob();
     lastSoapUse = currentTime;
     timeBasedCounter.reset(); //shake is allowed when there is normal usage
+    shakeDetector.reset();    // and the energy of the hand at the unit is no shake
     room.renewBackoff(); // when someone uses the soap, we dont need to execute the room procedure
   } else {
     soap.resetRunOnce(); // this prevents continuous soap, if the handsensor is continuously on
   }
 
   if (roomSensor_isOn) {
+    TIMELINE_RESUME(TRACK_ROOM);
     room.startJob();
     room.renewBackoff(); // this renewes the backoff when someone is constantly in the room. The "room experience" is only for when you enter the room
   } else {
@@ -687,11 +1117,12 @@ void loop() {
   }
 
   //--------------------------------------
-  // Periodic DFPlayer serial reinitialization (rollover-safe)
-  if ((unsigned long)(currentTime - lastDFPlayerReset) >= DFPLAYER_RESET_INTERVAL &&
-      (unsigned long)(currentTime - lastSoapUse) >= INACTIVITY_WINDOW) {
+  // Periodic DFPlayer serial reinitialization (rollover-safe). Only when idle: begin() drops
+  // pending queries without an answer (an SD scan waiting for one would never finish)
+  if ((uint32_t)(currentTime - lastDFPlayerReset) >= DFPLAYER_RESET_INTERVAL &&
+      (uint32_t)(currentTime - lastSoapUse) >= INACTIVITY_WINDOW && isUnitIdle()) {
 
-    Serial.println(F("Reinitializing DFPlayer serial interface after long uptime + inactivity..."));
+    LOG_INFO(LOG_DFPLAYER_REINIT);
     reinitializeDFPlayerSerial();
 
     lastDFPlayerReset = currentTime;  // Update timestamp safely
@@ -699,81 +1130,63 @@ void loop() {
 
 
   // ======================================
-  // new idea:
-  // add the analog signal to a counter
-  // decrease counter in each loop
-  // if counter too high, then tilt
+  // the shake detector integrates every ADC sample (see ShakeDetector.h) and reports incidents.
+  // Incidents during the shake backoff are dropped
+
+  // drops the shakes that left the window. Once per tick, so a 16 bit time can not wrap around
+  // an old shake and count it again
+  timeBasedCounter.expire(currentTime);
 
-  if(shakeSensor_value > SHAKE_SENSITIVITY && currentTime - timeBasedCounter.getLatestTime() > SHAKE_PICKUP_SPEED && !shake.isBackoffActive()) {
+  if(shakeDetector.takeIncident() && !shake.isBackoffActive()) {
 
     bool wereThereMultipleShakeIncidents = timeBasedCounter.addTimeAndCheck(currentTime);
+    TIMELINE_TRIGGER(TRACK_SHAKE);
 
-#ifdef DEBUG
-    Serial.println(F("================"));
-    Serial.print(wereThereMultipleShakeIncidents);
-    Serial.println(F(" = wereThereMultipleShakeIncidents"));
-    Serial.print(timeBasedCounter.getLatestTime());
-    Serial.println(F(" = latest time"));
-    Serial.print(currentTime);
-    Serial.println(F(" = current time"));
-
-    Serial.print(F("shake detected: shake value "));
-    Serial.println(shakeSensor_value);
-    Serial.print(timeBasedCounter.getCurrentShakeCounter(currentTime));
-    Serial.println(F(" is the current shakes detected"));
-    Serial.println(F("================"));
-#endif
+    // the peak of every incident, with or without the log (the macro compiles to nothing without LOG_LEVEL)
+    uint16_t peakEnergy = shakeDetector.takePeakEnergy();
+    (void)peakEnergy; // only used by the log
+    LOG_DEBUG(LOG_SHAKE_INCIDENT, peakEnergy, timeBasedCounter.getCurrentCount(currentTime));
 
     if(wereThereMultipleShakeIncidents) {
       shake.startJob();
+      shakeDetector.reset(); // the next shake starts from zero energy
     }
   }
 
 
   // ======================================
-  // WARNING, THIS BLOCKS THE LOOP FLOW
-  if ( button1.pressed() || button2.pressed() ) {
+  // folder selection. The beeps are played by beepMenuStep()
+  PROFILE_BEGIN(PROFILE_BUTTONS);
+  if ( buttonPressed[0] || buttonPressed[1] ) {
     
-    Serial.println(F("button1 pressed"));
     currentRoomFolder = currentRoomFolder + 1;
 
-    Serial.print(F("currentRoomFolder"));
-    Serial.println(currentRoomFolder);
-
-    
-    Serial.print(F("maxDetectedFolders"));
-    Serial.println(maxDetectedFolders);
-
     if(currentRoomFolder > maxDetectedFolders) {
       currentRoomFolder = (uint8_t) FOLDER_ROOM_START;
     }
 
-    Serial.print(F("sounds will be played from room "));
-    Serial.println(currentRoomFolder);
-
-    for(uint8_t i = FOLDER_ROOM_START; i <= currentRoomFolder; i++) {
-      mp3Player.playFolder(FOLDER_BEEP, 1);
-      delay(600);
-    }
-    mp3Player.stop();
+    LOG_INFO(LOG_ROOM_FOLDER, currentRoomFolder, maxDetectedFolders);
 
+    TIMELINE_RESUME(buttonPressed[0] ? TRACK_BUTTON1 : TRACK_BUTTON2);
+    startBeepMenu();
   }
+  beepMenuStep();
 
 
   //pump manual override
-  if(button3.pressed()) {
-    Serial.println(F("Manual soap on "));
+  if(buttonPressed[2]) {
+    LOG_INFO(LOG_MANUAL_SOAP, 1);
     digitalWrite(PUMP_PIN, LOW);
-  } else if(button3.released()) {
-    Serial.println(F("manual soap off"));
+  } else if(buttonReleased[2]) {
+    LOG_INFO(LOG_MANUAL_SOAP, 0);
     digitalWrite(PUMP_PIN, HIGH);
   }
+  PROFILE_END(PROFILE_BUTTONS);
 
 }
 
 
 void ledOnStart() {
-  // Serial.println(F("LED on"));
   analogWrite(LED1_PIN, LED1_BRIGHTNESS);
   analogWrite(LED2_PIN, LED2_BRIGHTNESS);
 }
@@ -781,7 +1194,6 @@ void ledOnEnd() {
   ledOff.startJob();
 }
 void ledOffStart() {
-  // Serial.println(F("LED off"));
   digitalWrite(LED1_PIN, LOW);
   digitalWrite(LED2_PIN, LOW);
 }
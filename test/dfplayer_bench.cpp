@@ -0,0 +1,100 @@
+// Throughput of the DFPlayer frame parser (DFRobotDFPlayerMini::available()) on the host:
+// bytes per second, ns and cycles per frame, and the time of one available() call, which bounds
+// the cost of the parser in one loop() tick. Compare the numbers before and after a parser change
+// (on the board one cycle is 62.5 ns).
+//   dfplayer_bench [frames]
+
+#include <algorithm>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_CYCLES() __rdtsc()
+#else
+#define BENCH_CYCLES() 0
+#endif
+
+#include "DFRobotDFPlayerMini.h"
+#include "HostClock.h"
+
+// All bytes of a scenario, handed to the parser like a serial buffer
+class MemoryLine : public Stream {
+public:
+  std::vector<uint8_t> bytes;
+  size_t position = 0;
+
+  int available() override {
+    size_t left = bytes.size() - position;
+    return left > 63 ? 63 : (int)left;
+  }
+  int read() override { return position < bytes.size() ? bytes[position++] : -1; }
+  int peek() override { return position < bytes.size() ? bytes[position] : -1; }
+  size_t write(uint8_t) override { return 1; }
+  using Print::write;
+};
+
+static void pushFrame(MemoryLine& line, uint8_t command, uint16_t parameter) {
+  uint8_t frame[DFPLAYER_RECEIVED_LENGTH] = { 0x7E, 0xFF, 0x06, command, 0x00, (uint8_t)(parameter >> 8),
+                                               (uint8_t)parameter, 0, 0, 0xEF };
+  uint16_t checksum = 0 - (frame[1] + frame[2] + frame[3] + frame[4] + frame[5] + frame[6]);
+  frame[7] = checksum >> 8;
+  frame[8] = checksum & 0xFF;
+  line.bytes.insert(line.bytes.end(), frame, frame + DFPLAYER_RECEIVED_LENGTH);
+}
+
+static void run(const char* name, MemoryLine& line, uint32_t frames) {
+  DFRobotDFPlayerMini player;
+  player.begin(line, false, false);
+  std::vector<uint32_t> calls;  // ns per available() call
+  uint32_t events = 0;
+  uint64_t cycles = BENCH_CYCLES();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  while (line.position < line.bytes.size()) {
+    std::chrono::steady_clock::time_point callStart = std::chrono::steady_clock::now();
+    player.available();
+    uint8_t type;
+    uint16_t parameter;
+    while (player.readEvent(type, parameter)) {
+      events++;
+    }
+    calls.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - callStart).count());
+  }
+  double ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  cycles = BENCH_CYCLES() - cycles;
+  // the host preempts now and then, the 99.9th percentile is the cost of the parser
+  std::sort(calls.begin(), calls.end());
+  printf("%-8s %6.1f MB/s %7.1f ns/frame %6.0f cycles/frame %6u ns per call (99.9%%) %8u events\n", name,
+         line.bytes.size() / ns * 1000.0, ns / frames, (double)cycles / frames,
+         (unsigned)calls[calls.size() * 999 / 1000], (unsigned)events);
+}
+
+int main(int argc, char** argv) {
+  uint32_t frames = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+  srand(1);
+
+  // events and ACKs as they come from the module
+  MemoryLine clean;
+  for (uint32_t i = 0; i < frames; i++) {
+    pushFrame(clean, i % 2 ? 0x41 : 0x3D, i);
+  }
+  run("clean", clean, frames);
+
+  // frames behind 0-11 bytes of noise
+  MemoryLine noise;
+  for (uint32_t i = 0; i < frames; i++) {
+    for (int n = rand() % 12; n > 0; n--) {
+      noise.bytes.push_back(rand());
+    }
+    pushFrame(noise, 0x3D, i);
+  }
+  run("noise", noise, frames);
+
+  // worst case for the resync: headers that never become a frame (a "frame" is 10 bytes here)
+  MemoryLine headers;
+  for (uint32_t i = 0; i < frames * DFPLAYER_RECEIVED_LENGTH / 3; i++) {
+    headers.bytes.push_back(0x7E);
+    headers.bytes.push_back(0xFF);
+    headers.bytes.push_back(0x06);
+  }
+  run("headers", headers, frames);
+  return 0;
+}
@@ -0,0 +1,310 @@
+// Fuzzes the DFPlayer frame parser (DFRobotDFPlayerMini::available()), the only code that reads
+// untrusted bytes from the serial line.
+//  1. Valid frames behind random noise, mixed with mutated frames (flipped, truncated, duplicated
+//     bytes): every frame behind noise must be parsed, whatever the noise or broken frame before it.
+//  2. A session with the emulator with all its faults on and noise on the line: after the faults end
+//     the parser has to be in sync again, a played file finishes and a query is answered.
+//  3. A query response that overtakes its ACK: the late ACK must not settle the next command.
+// In both every available() call must read at most DFPLAYER_PARSE_BUDGET bytes.
+//   dfplayer_fuzz [frames] [seed]
+
+#include "DFRobotDFPlayerMini.h"
+#include "DFPlayerEmulator.h"
+#include "HostClock.h"
+
+static uint32_t failures = 0;
+
+static void check(bool condition, const char* what, uint32_t value) {
+  if (!condition) {
+    if (failures < 20) {
+      printf("FAIL: %s (%u)\n", what, (unsigned)value);
+    }
+    failures++;
+  }
+}
+
+// Line between the parser and a source of bytes. Counts the bytes each available() call reads.
+class FuzzLine : public Stream {
+public:
+  explicit FuzzLine(Stream* module = nullptr) : module(module) {}
+
+  void push(uint8_t value) { bytes.push_back(value); }
+
+  // noise between the bytes of the module, per mille per byte
+  void setNoise(uint16_t perMille) { noisePerMille = perMille; }
+
+  int available() override {
+    size_t left = bytes.size() - position;
+    if (left == 0 && module && module->available()) {
+      receiveFromModule();
+      left = bytes.size() - position;
+    }
+    return left > 63 ? 63 : (int)left;
+  }
+
+  int read() override {
+    if (!available()) {
+      return -1;
+    }
+    readsInCall++;
+    return bytes[position++];
+  }
+
+  int peek() override { return available() ? bytes[position] : -1; }
+
+  size_t write(uint8_t value) override { return module ? module->write(value) : 1; }
+  using Print::write;
+
+  bool empty() { return position == bytes.size(); }
+  uint16_t readsInCall = 0;
+
+private:
+  void receiveFromModule() {
+    bytes.clear();
+    position = 0;
+    if (noisePerMille && (uint16_t)(rand() % 1000) < noisePerMille) {
+      for (int i = rand() % 4; i >= 0; i--) {
+        push(rand());
+      }
+    }
+    push(module->read());
+  }
+
+  Stream* module;
+  std::vector<uint8_t> bytes;
+  size_t position = 0;
+  uint16_t noisePerMille = 0;
+};
+
+static void pushFrame(FuzzLine& line, uint8_t command, uint16_t parameter, uint8_t* frame) {
+  frame[0] = 0x7E;
+  frame[1] = 0xFF;
+  frame[2] = 0x06;
+  frame[3] = command;
+  frame[4] = 0x00;
+  frame[5] = parameter >> 8;
+  frame[6] = parameter & 0xFF;
+  uint16_t checksum = 0 - (frame[1] + frame[2] + frame[3] + frame[4] + frame[5] + frame[6]);
+  frame[7] = checksum >> 8;
+  frame[8] = checksum & 0xFF;
+  frame[9] = 0xEF;
+}
+
+// Parses everything on the line, returns the parameters of the "play finished" events in order
+static void parseAll(DFRobotDFPlayerMini& player, FuzzLine& line, std::vector<uint16_t>& finished) {
+  while (!line.empty()) {
+    line.readsInCall = 0;
+    player.available();
+    check(line.readsInCall <= DFPLAYER_PARSE_BUDGET, "bytes parsed in one available() call", line.readsInCall);
+    uint8_t type;
+    uint16_t parameter;
+    while (player.readEvent(type, parameter)) {
+      if (type == DFPlayerPlayFinished) {
+        finished.push_back(parameter);
+      }
+    }
+  }
+}
+
+static void fuzzNoise(uint32_t frames) {
+  FuzzLine line;
+  DFRobotDFPlayerMini player;
+  player.begin(line, false, false);
+
+  std::vector<uint16_t> expected;
+  std::vector<uint16_t> finished;
+  uint8_t frame[DFPLAYER_RECEIVED_LENGTH];
+  for (uint32_t i = 0; i < frames; i++) {
+    uint16_t track = rand();
+    pushFrame(line, 0x3D, track, frame);
+    switch (rand() % 4) {
+      case 0: {  // a broken frame, it may be lost. It must not take the next frame with it.
+        uint8_t length = DFPLAYER_RECEIVED_LENGTH;
+        switch (rand() % 3) {
+          case 0:
+            frame[rand() % DFPLAYER_RECEIVED_LENGTH] ^= 1 << (rand() % 8);
+            break;
+          case 1:
+            length = 1 + rand() % (DFPLAYER_RECEIVED_LENGTH - 1);
+            break;
+          default:
+            frame[rand() % DFPLAYER_RECEIVED_LENGTH] = 0x7E;
+            break;
+        }
+        for (uint8_t b = 0; b < length; b++) {
+          line.push(frame[b]);
+        }
+        break;
+      }
+      default: {  // noise, then a valid frame that has to arrive
+        for (int n = rand() % 12; n > 0; n--) {
+          line.push(rand() % 3 ? rand() : 0x7E);
+        }
+        for (uint8_t b = 0; b < DFPLAYER_RECEIVED_LENGTH; b++) {
+          line.push(frame[b]);
+        }
+        expected.push_back(track);
+        break;
+      }
+    }
+  }
+  // a last clean frame ends a trailing broken one
+  pushFrame(line, 0x3D, 0, frame);
+  for (uint8_t b = 0; b < DFPLAYER_RECEIVED_LENGTH; b++) {
+    line.push(frame[b]);
+  }
+  expected.push_back(0);
+  parseAll(player, line, finished);
+
+  // broken frames and noise can add events, but none of the expected ones may be missing
+  size_t found = 0;
+  size_t next = 0;
+  for (uint16_t track : expected) {
+    for (size_t i = next; i < finished.size() && i < next + 8; i++) {
+      if (finished[i] == track) {
+        found++;
+        next = i + 1;
+        break;
+      }
+    }
+  }
+  check(found == expected.size(), "frames behind noise lost", (uint32_t)(expected.size() - found));
+  check(player.droppedEvents() == 0, "events dropped", player.droppedEvents());
+  printf("noise: %u frames behind noise, %u parsed, %u rejected\n", (unsigned)expected.size(),
+         (unsigned)found, (unsigned)player.rejectedFrames());
+}
+
+static int lastQueryValue = -2;
+
+static void queryAnswered(uint8_t, int value) {
+  lastQueryValue = value;
+}
+
+// Runs the parser and the emulator for ms milliseconds, collecting the events
+static void runSession(DFRobotDFPlayerMini& player, FuzzLine& line, uint32_t ms, std::vector<uint8_t>* types) {
+  for (uint32_t i = 0; i < ms; i++) {
+    line.readsInCall = 0;
+    player.available();
+    check(line.readsInCall <= DFPLAYER_PARSE_BUDGET, "bytes parsed in one available() call", line.readsInCall);
+    uint8_t type;
+    uint16_t parameter;
+    while (player.readEvent(type, parameter)) {
+      if (types) {
+        types->push_back(type);
+      }
+    }
+    hostAdvance(1000);
+  }
+}
+
+static void fuzzEmulator(uint32_t commands) {
+  DFPlayerEmulator module;
+  module.setFolder(1, 3, 300);
+  module.setFolder(2, 5, 500);
+  module.setByteTime(1);
+  module.begin(9600);
+  FuzzLine line(&module);
+  DFRobotDFPlayerMini player;
+  player.begin(line, true, true);
+
+  module.setDropBytes(20);
+  module.setBadChecksums(50);
+  module.setDuplicateFrames(50);
+  module.setReorderReplies(100);
+  line.setNoise(30);
+  for (uint32_t i = 0; i < commands; i++) {
+    switch (rand() % 4) {
+      case 0:
+        player.playFolder(1 + rand() % 3, 1 + rand() % 6);
+        break;
+      case 1:
+        player.volume(rand() % 31);
+        break;
+      case 2:
+        player.queryFileCountsInFolder(1 + rand() % 3, queryAnswered);
+        break;
+      default:
+        player.stop();
+        break;
+    }
+    runSession(player, line, rand() % 400, nullptr);
+  }
+
+  // faults end: give retransmits and late replies time, then the line has to work again
+  module.setDropBytes(0);
+  module.setBadChecksums(0);
+  module.setDuplicateFrames(0);
+  module.setReorderReplies(0);
+  line.setNoise(0);
+  player.stop();
+  runSession(player, line, 3000, nullptr);
+  check(player.pendingCommands() == 0, "commands still pending after the faults", player.pendingCommands());
+
+  uint16_t rejected = player.rejectedFrames();
+  std::vector<uint8_t> types;
+  player.playFolder(2, 4);
+  runSession(player, line, 1000, &types);
+  bool finished = false;
+  for (uint8_t type : types) {
+    finished |= type == DFPlayerPlayFinished;
+  }
+  check(finished, "play finished after the faults", (uint32_t)types.size());
+  lastQueryValue = -2;
+  player.queryFileCountsInFolder(2, queryAnswered);
+  runSession(player, line, 500, nullptr);
+  check(lastQueryValue == 5, "query answered after the faults", (uint32_t)lastQueryValue);
+  check(player.rejectedFrames() == rejected, "frames rejected after the faults", player.rejectedFrames() - rejected);
+  printf("emulator: %u commands, %u frames received, %u rejected, %u retransmitted\n", (unsigned)commands,
+         (unsigned)player.receivedFrames(), (unsigned)rejected, (unsigned)player.retransmittedCommands());
+}
+
+static void lateAck() {
+  DFPlayerEmulator module;
+  module.setFolder(1, 3, 300);
+  module.setAckDelay(60);
+  module.setResponseDelay(5);
+  module.begin(9600);
+  FuzzLine line(&module);
+  DFRobotDFPlayerMini player;
+  player.begin(line, true, true);
+  runSession(player, line, 100, nullptr);
+  uint16_t retransmitted = player.retransmittedCommands();
+
+  // the response to the query settles it after 5 ms, its ACK follows at 60 ms while the volume is in flight
+  lastQueryValue = -2;
+  player.queryFolderCounts(queryAnswered);
+  player.volume(10);
+  runSession(player, line, 70, nullptr);
+  check(lastQueryValue == 1, "query answered before its ACK", (uint32_t)lastQueryValue);
+  check(player.pendingCommands() == 1, "command settled by the ACK of the query", player.pendingCommands());
+  runSession(player, line, 100, nullptr);
+  check(player.pendingCommands() == 0, "command not settled by its own ACK", player.pendingCommands());
+  check(player.retransmittedCommands() == retransmitted, "commands retransmitted",
+        player.retransmittedCommands() - retransmitted);
+
+  // blocking read: the same holds, and the response belongs to the command asked for
+  check(player.readFolderCounts() == 1, "blocking query answered", 0);
+  player.volume(20);
+  runSession(player, line, 60, nullptr);
+  check(player.pendingCommands() == 1, "command settled by the ACK of the blocking query", player.pendingCommands());
+  runSession(player, line, 100, nullptr);
+  check(player.pendingCommands() == 0 && module.volume() == 20, "volume after the blocking query", module.volume());
+  printf("late ack: %u frames received, %u retransmitted\n", (unsigned)player.receivedFrames(),
+         (unsigned)(player.retransmittedCommands() - retransmitted));
+}
+
+int main(int argc, char** argv) {
+  uint32_t frames = argc > 1 ? strtoul(argv[1], nullptr, 10) : 200000;
+  srand(argc > 2 ? strtoul(argv[2], nullptr, 10) : 1);
+
+  fuzzNoise(frames);
+  fuzzEmulator(frames / 200);
+  lateAck();
+
+  if (failures) {
+    printf("%u failures\n", (unsigned)failures);
+    return 1;
+  }
+  printf("ok\n");
+  return 0;
+}
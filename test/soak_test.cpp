@@ -0,0 +1,377 @@
+// Time accelerated soak test of the sketch: days of random visitors, hands, room presence and shakes
+// on the virtual clock, through the millis() wrap. Checks after every loop():
+//  - the bird: never out twice, never in without out, never both motors, never out for more than 30 s
+//  - the pump: never on for more than 1 s, at least the soap backoff between two runs
+//  - the backoffs of the room and shake sounds
+// and prints the event counts and the worst hand to pump latency. Regression cases:
+//  - a DFPlayer reset due while the unit is busy (it used to break the SD card scan)
+//  - a shake counted again 65536 ms later (16 bit times in TimeBasedCounter)
+//  - the folder beeps during the SD card scan, and a room presence during the beeps
+//  - a warm boot with the catalog in the EEPROM (it used to keep the DFPlayer at full volume), and
+//    with another card of the same number of files
+//  - a sound right after the backoff of the last one, while its bird may still go in
+// The sketch keeps its state in globals, so each case runs in its own process (see CMakeLists.txt for
+// the HOST_START_MILLIS of each):
+//   soak_test soak [days] [seed] | reset | shake | menu | reboot | birdin
+
+#include "Simulation.h"
+#include "DFRobotDFPlayerMini.h"
+
+// script.ino
+extern DFRobotDFPlayerMini mp3Player;
+extern uint8_t folderFileCounts[];
+bool isSdScanActive();
+
+static const uint64_t WRAP_MILLIS = 4294967296ULL;
+static const uint64_t SOAP_BACKOFF = 2000;
+static const uint64_t ROOM_SOUND_GAP = 500 + 60000;   // room job and its backoff
+static const uint64_t SHAKE_SOUND_GAP = 550 + 10000;  // shake job and its backoff
+static const uint64_t HAND_LATENCY_LIMIT = 30;        // a hand wakes the unit at once
+
+static uint32_t failures = 0;
+
+static uint64_t now() {
+  return hostTime() / 1000;
+}
+
+static void fail(const char* what) {
+  if (failures < 20) {
+    printf("FAIL at %.0f ms: %s\n", (double)now(), what);
+  }
+  failures++;
+}
+
+// --- Observed outputs ---
+static bool pumpRunning = false;
+static uint64_t pumpStart = 0;
+static uint64_t pumpEnd = 0;
+static uint32_t pumpRuns = 0;
+static bool birdOut = false;
+static uint64_t birdOutTime = 0;
+static uint32_t birdMoves = 0;
+static bool handWaiting = false;
+static uint64_t handEdge = 0;
+static uint64_t maxHandLatency = 0;
+
+static void watchPins(uint8_t pin, uint8_t level) {
+  if (pin == SIM_PUMP_PIN) {
+    if (level == LOW && !pumpRunning) {
+      if (pumpRuns > 0 && now() - pumpEnd < SOAP_BACKOFF) {
+        fail("soap backoff not honored");
+      }
+      pumpRunning = true;
+      pumpStart = now();
+      pumpRuns++;
+      if (handWaiting) {
+        maxHandLatency = now() - handEdge > maxHandLatency ? now() - handEdge : maxHandLatency;
+        handWaiting = false;
+      }
+    } else if (level == HIGH && pumpRunning) {
+      pumpRunning = false;
+      pumpEnd = now();
+    }
+  } else if (pin == SIM_BIRD_MOTOR1_VCC_PIN && level == LOW) {
+    if (birdOut) {
+      fail("double bird");
+    }
+    birdOut = true;
+    birdOutTime = now();
+    birdMoves++;
+  } else if (pin == SIM_BIRD_MOTOR2_VCC_PIN && level == LOW) {
+    if (!birdOut) {
+      fail("bird in without out");
+    }
+    birdOut = false;
+  }
+  if (hostOutput(SIM_BIRD_MOTOR1_VCC_PIN) == LOW && hostOutput(SIM_BIRD_MOTOR2_VCC_PIN) == LOW) {
+    fail("both bird motors driven");
+  }
+}
+
+// --- Observed sounds (play commands to the DFPlayer, the SD card scan plays files as well) ---
+static uint32_t roomSounds = 0;
+static uint32_t shakeSounds = 0;
+static uint64_t lastRoomSound = 0;
+static uint64_t lastShakeSound = 0;
+
+static void watchFrames(bool received, uint8_t command, uint16_t parameter) {
+  if (received || command != 0x0F || isSdScanActive()) {
+    return;
+  }
+  uint8_t folder = parameter >> 8;
+  if (folder >= SIM_FOLDER_ROOM_START) {
+    if (roomSounds > 0 && now() - lastRoomSound < ROOM_SOUND_GAP) {
+      fail("room backoff not honored");
+    }
+    roomSounds++;
+    lastRoomSound = now();
+  } else if (folder == SIM_FOLDER_SHAKE) {
+    if (shakeSounds > 0 && now() - lastShakeSound < SHAKE_SOUND_GAP) {
+      fail("shake backoff not honored");
+    }
+    shakeSounds++;
+    lastShakeSound = now();
+  }
+}
+
+static void checkStuck() {
+  if (pumpRunning && now() - pumpStart > 1000) {
+    fail("stuck pump");
+    pumpStart = now();
+  }
+  if (birdOut && now() - birdOutTime > 30000) {
+    fail("stuck bird");
+    birdOutTime = now();
+  }
+}
+
+static void begin() {
+  beginSimulation();
+  hostSetPinWriteHook(watchPins);
+  mp3Player.setFrameTap(watchFrames);
+  // the scan of the new SD card
+  runSimulation(60000, checkStuck);
+  if (isSdScanActive()) {
+    fail("SD card scan not finished after a minute");
+  }
+}
+
+static void run(uint64_t ms) {
+  runSimulation(ms, checkStuck);
+}
+
+static void hand(uint64_t ms) {
+  setHand(true);
+  handEdge = now();
+  handWaiting = !pumpRunning && now() - pumpEnd >= SOAP_BACKOFF + 100;
+  run(ms);
+  setHand(false);
+  if (handWaiting) {
+    fail("no soap for a hand");
+    handWaiting = false;
+  }
+}
+
+static void shakeOnce() {
+  setShaking(150);
+  run(300);
+  setShaking(0);
+  run(500);
+}
+
+// --- Soak ---
+static void soak(uint32_t days) {
+  begin();
+  uint32_t eepromWrites = hostEepromWrites();
+  uint64_t end = now() + days * 24ULL * 60 * 60 * 1000;
+  if (end < WRAP_MILLIS) {
+    printf("the soak ends before the millis() wrap, start later with HOST_START_MILLIS\n");
+  }
+  while (now() < end) {
+    switch (rand() % 8) {
+      case 0:  // somebody enters the room, washes the hands and leaves
+        setRoom(true);
+        run(1000 + rand() % 5000);
+        hand(200 + rand() % 1500);
+        run(rand() % 20000);
+        setRoom(false);
+        break;
+      case 1:  // several hands in a row
+        setRoom(true);
+        for (int i = rand() % 5; i >= 0; i--) {
+          hand(200 + rand() % 1500);
+          run(rand() % 4000);
+        }
+        setRoom(false);
+        break;
+      case 2:  // someone rattles the unit
+        for (int i = rand() % 4; i >= 0; i--) {
+          shakeOnce();
+        }
+        break;
+      case 3:  // someone stays in the room
+        setRoom(true);
+        run(60000 + rand() % 300000);
+        setRoom(false);
+        break;
+      default:  // nobody
+        run(rand() % 1200000);
+        break;
+    }
+    run(100 + rand() % 3000);
+  }
+  checkStuck();
+  printf("soak: %u days, %u pump runs, %u bird moves, %u room sounds, %u shake sounds, "
+         "hand to pump at most %u ms, %u EEPROM writes\n", (unsigned)days, (unsigned)pumpRuns,
+         (unsigned)birdMoves, (unsigned)roomSounds, (unsigned)shakeSounds, (unsigned)maxHandLatency,
+         (unsigned)(hostEepromWrites() - eepromWrites));
+  if (maxHandLatency > HAND_LATENCY_LIMIT) {
+    fail("hand to pump latency");
+  }
+  if (pumpRuns == 0 || birdMoves == 0 || roomSounds == 0 || shakeSounds == 0) {
+    fail("no traffic");
+  }
+}
+
+// The DFPlayer reset is due at power on (11 days uptime, no soap used). It has to wait for the scan
+// of the SD card, then the unit has to work.
+static void resetWhileBusy() {
+  begin();
+  if (now() < 10ULL * 24 * 60 * 60 * 1000) {
+    fail("the DFPlayer reset is not due, start with HOST_START_MILLIS at 10 days or later");
+  }
+  run(3ULL * 60 * 60 * 1000 + 60000);  // the inactivity window before the reset
+  uint32_t birds = birdMoves;
+  uint32_t pumps = pumpRuns;
+  hand(500);
+  run(10000);
+  if (birdMoves == birds || pumpRuns == pumps) {
+    fail("no bird or soap after the DFPlayer reset");
+  }
+}
+
+// Three shakes, then one more after 65.5 s: a 16 bit time in the shake window would see four
+// (COUNTER_SIZE times in the window, and one more starts the shake sound).
+static void shakeCountedAgain() {
+  begin();
+  uint32_t sounds = shakeSounds;
+  for (int i = 0; i < 4; i++) {
+    shakeOnce();
+  }
+  run(2000);
+  if (shakeSounds == sounds) {
+    fail("four shakes in the window give no shake sound");
+  }
+  run(20000);  // the shake backoff
+
+  sounds = shakeSounds;
+  uint64_t first = now();
+  for (int i = 0; i < 3; i++) {
+    shakeOnce();
+  }
+  run(65536 - (now() - first));
+  shakeOnce();
+  run(2000);
+  if (shakeSounds != sounds) {
+    fail("a shake 65536 ms ago counted again");
+  }
+}
+
+static void checkBeepAudible() {
+  checkStuck();
+  DFPlayerEmulator& player = simulatedPlayer();
+  if (player.isPlaying() && player.playingFolder() == SIM_FOLDER_BEEP && player.volume() == 0) {
+    fail("beep muted by the SD card scan");
+  }
+}
+
+static void pressButton() {
+  setButton(1, true);
+  run(100);
+  setButton(1, false);
+}
+
+// The folder beeps pause the SD card scan, which counts the interrupted folder again afterwards.
+// A room presence during the beeps plays its sound after them.
+static void beepMenu() {
+  beginSimulation();
+  hostSetPinWriteHook(watchPins);
+  mp3Player.setFrameTap(watchFrames);
+  for (int i = 0; i < 20; i++) {
+    pressButton();
+    runSimulation(200 + rand() % 1500, checkBeepAudible);
+  }
+  run(60000);
+  if (isSdScanActive() || folderFileCounts[SIM_FOLDER_ROOM_START] != 7) {
+    fail("SD card scan broken by the folder beeps");
+  }
+
+  uint32_t sounds = roomSounds;
+  pressButton();
+  setRoom(true);
+  run(5000);
+  setRoom(false);
+  if (roomSounds == sounds) {
+    fail("room sound lost during the folder beeps");
+  }
+}
+
+// The second boot loads the catalog instead of scanning, the volume has to be set all the same
+static void warmBoot() {
+  begin();
+  run(10000);
+  uint32_t frames = simulatedPlayer().framesReceived();
+  rebootSimulation();
+  run(10000);
+  if (isSdScanActive() || folderFileCounts[SIM_FOLDER_ROOM_START] != 7) {
+    fail("catalog not loaded at the warm boot");
+  }
+  if (simulatedPlayer().framesReceived() - frames > 20) {
+    fail("SD card scanned again at the warm boot");
+  }
+  if (simulatedPlayer().volume() != SIM_VOLUME) {
+    fail("volume not set at the warm boot");
+  }
+
+  // the 7 room sounds in two folders: setup() sets the card of script.ino, change it before the scan
+  rebootSimulation();
+  simulatedPlayer().setFolder(SIM_FOLDER_ROOM_START, 4, 2800);
+  simulatedPlayer().setFolder(SIM_FOLDER_ROOM_START + 1, 3, 2800);
+  run(60000);
+  if (isSdScanActive() || folderFileCounts[SIM_FOLDER_ROOM_START] != 4 || folderFileCounts[SIM_FOLDER_ROOM_START + 1] != 3) {
+    fail("catalog of another card with the same number of files loaded");
+  }
+}
+
+// The soap pattern (no lip sync table once the learned duration does not fit it) is bird out 0-240 ms,
+// break, flap, break 940-1540 ms, bird in. A bird sound of 930 ms ends in the last break, its backoff
+// ends at about 1750 ms: a room presence then starts the next bird while this one may still go in.
+// Swept over the backoff end, as the exact times depend on the DFPlayer.
+static void soundDuringBirdIn() {
+  begin();
+  run(65000);  // the room backoff of the power on, the soap would renew it
+  for (int i = 0; i < 16; i++) {
+    simulatedPlayer().setFolder(SIM_FOLDER_BIRD, 1, 690);  // learned: too short for the lip sync table
+    hand(300);
+    run(5000);
+    simulatedPlayer().setFolder(SIM_FOLDER_BIRD, 1, 930);
+    hand(300);
+    while (simulatedPlayer().isPlaying()) {
+      run(1);
+    }
+    run(810 + i * 4);
+    uint32_t birds = birdMoves;
+    setRoom(true);
+    run(5000);
+    setRoom(false);
+    if (birdMoves == birds) {
+      fail("no bird for the room sound");
+    }
+    run(65000);  // the room backoff
+  }
+}
+
+int main(int argc, char** argv) {
+  const char* name = argc > 1 ? argv[1] : "soak";
+  if (!strcmp(name, "reset")) {
+    resetWhileBusy();
+  } else if (!strcmp(name, "shake")) {
+    shakeCountedAgain();
+  } else if (!strcmp(name, "menu")) {
+    beepMenu();
+  } else if (!strcmp(name, "reboot")) {
+    warmBoot();
+  } else if (!strcmp(name, "birdin")) {
+    soundDuringBirdIn();
+  } else {
+    srand(argc > 3 ? strtoul(argv[3], nullptr, 10) : 1);
+    soak(argc > 2 ? strtoul(argv[2], nullptr, 10) : 2);
+  }
+
+  if (failures) {
+    printf("%u failures\n", (unsigned)failures);
+    return 1;
+  }
+  printf("ok\n");
+  return 0;
+}
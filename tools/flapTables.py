@@ -0,0 +1,209 @@
+#!/usr/bin/env python3
+"""Generates script/FlapTables.h: flap/break tables that move the bird's beak with the speech.
+
+Reads the WAV files of the SD card in resources/NN-name/NNN.wav, follows the amplitude envelope
+of each file and turns loud parts into flaps and quiet parts into breaks. The durations are
+quantized to FLAP_TICK_MS and stored in PROGMEM, keyed by folder and file number.
+
+Run it again whenever the sounds in resources change:
+    python3 tools/flapTables.py
+"""
+
+import argparse
+import glob
+import os
+import re
+import sys
+import wave
+from array import array
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+NO_BIRD_FOLDERS = {2, 3}   # shake sensor and menu beep: the bird stays in
+
+TICK_MS = 10               # FLAP_TICK_MS in BirdFlapGenerator.h
+WINDOW_MS = 10             # envelope resolution
+FLAP_MIN = 50              # same limits as the random generator (BirdFlapGenerator.cpp)
+FLAP_MAX = 170
+BREAK_MIN = 80
+MAX_TICKS = 255            # one byte per duration
+DIP = 0.6                  # a syllable ends where the envelope falls below 60 % of its peak and rises again
+FLAP_SHARE = 60            # % of a syllable the beak is open
+
+
+def read_envelope(path):
+    """RMS of every WINDOW_MS window, mixed down to mono"""
+    with wave.open(path) as wav:
+        if wav.getsampwidth() != 2:
+            raise ValueError("%s: only 16 bit PCM is supported" % path)
+        channels = wav.getnchannels()
+        rate = wav.getframerate()
+        samples = array("h", wav.readframes(wav.getnframes()))
+    if sys.byteorder == "big":
+        samples.byteswap()
+
+    window = rate * WINDOW_MS // 1000 * channels
+    envelope = []
+    for start in range(0, len(samples) - window + 1, window):
+        chunk = samples[start:start + window]
+        envelope.append((sum(s * s for s in chunk) / len(chunk)) ** 0.5)
+    duration = len(samples) * 1000 // (rate * channels)
+    return envelope, duration
+
+
+def voiced_segments(envelope):
+    """(start, end) in ms of the loud parts, with hysteresis between a high and a low threshold"""
+    ordered = sorted(envelope)
+    noise = ordered[len(ordered) // 10]
+    peak = ordered[len(ordered) * 95 // 100]
+    on_level = noise + 0.30 * (peak - noise)
+    off_level = noise + 0.15 * (peak - noise)
+
+    segments = []
+    start = None
+    for i, level in enumerate(envelope):
+        if start is None and level > on_level:
+            start = i * WINDOW_MS
+        elif start is not None and level < off_level:
+            segments.append((start, i * WINDOW_MS))
+            start = None
+    if start is not None:
+        segments.append((start, len(envelope) * WINDOW_MS))
+
+    # short pauses do not close the beak
+    merged = []
+    for segment in segments:
+        if merged and segment[0] - merged[-1][1] < BREAK_MIN:
+            merged[-1] = (merged[-1][0], segment[1])
+        else:
+            merged.append(segment)
+    return merged
+
+
+def syllables(segments, envelope):
+    """Splits the loud parts at the dips of the envelope: one (start, end) in ms per syllable"""
+    smooth = [sum(envelope[max(0, i - 1):i + 2]) / len(envelope[max(0, i - 1):i + 2]) for i in range(len(envelope))]
+
+    result = []
+    for start, end in segments:
+        first = start // WINDOW_MS
+        last = end // WINDOW_MS
+        boundary = first
+        peak = 0.0
+        dip = None                   # index of the lowest level since the peak
+        for i in range(first, last):
+            level = smooth[i]
+            if dip is None:
+                if level > peak:
+                    peak = level
+                elif level < DIP * peak:
+                    dip = i
+            elif level < smooth[dip]:
+                dip = i
+            elif smooth[dip] < DIP * level:
+                # the level rose again: the dip separates two syllables
+                result.append((boundary * WINDOW_MS, dip * WINDOW_MS))
+                boundary = dip
+                peak = level
+                dip = None
+        result.append((boundary * WINDOW_MS, end))
+    return result
+
+
+def flap_times(syllable_times, offset, duration):
+    """Absolute (start, end) of each flap, starting once the bird is out (offset ms)"""
+    flaps = []
+    earliest = offset
+    for start, end in syllable_times:
+        start = max(start, earliest)
+        # the beak opens with the syllable and closes before the next one
+        while start < end and start < duration:
+            length = max(FLAP_MIN, min(FLAP_MAX, (end - start) * FLAP_SHARE // 100))
+            flap_end = min(duration, start + length)
+            flaps.append((start, flap_end))
+            start = earliest = flap_end + BREAK_MIN
+    return flaps
+
+
+def quantize(flaps, offset, duration, name):
+    """Breaks and flaps in ticks. The boundaries are rounded, not the durations, so there is no drift"""
+    def tick(ms):
+        return int(round((ms - offset) / TICK_MS))
+
+    breaks = []
+    flap_ticks = []
+    position = 0
+    for start, end in flaps:
+        breaks.append(tick(start) - position)
+        flap_ticks.append(max(1, tick(end) - tick(start)))
+        position = tick(start) + flap_ticks[-1]
+    breaks.append(max(0, tick(duration) - position))   # until the end of the sound: bird in
+
+    if breaks and breaks[0] == 0:
+        breaks.pop(0)                                   # starts with a flap
+    for values in (breaks, flap_ticks):
+        for i, value in enumerate(values):
+            if value > MAX_TICKS:
+                print("%s: %d ms pause shortened to %d ms" % (name, value * TICK_MS, MAX_TICKS * TICK_MS),
+                      file=sys.stderr)
+                values[i] = MAX_TICKS
+    return flap_ticks, breaks
+
+
+def c_array(name, values):
+    lines = []
+    for i in range(0, len(values), 20):
+        lines.append("  " + ", ".join(str(v) for v in values[i:i + 20]))
+    return "static const uint8_t %s[] PROGMEM = {\n%s\n};\n" % (name, ",\n".join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--resources", default=os.path.join(ROOT, "resources"))
+    parser.add_argument("--output", default=os.path.join(ROOT, "script", "FlapTables.h"))
+    parser.add_argument("--offset", type=int, default=240,
+                        help="ms of sound before the first flap, BIRD_OUT_TIME in script.ino")
+    args = parser.parse_args()
+
+    tables = []
+    for path in sorted(glob.glob(os.path.join(args.resources, "*", "*.wav"))):
+        folder_match = re.match(r"(\d\d)-", os.path.basename(os.path.dirname(path)))
+        file_match = re.match(r"(\d\d\d)\.wav$", os.path.basename(path))
+        if not folder_match or not file_match:
+            continue
+        folder = int(folder_match.group(1))
+        file = int(file_match.group(1))
+        if folder in NO_BIRD_FOLDERS:
+            continue
+
+        envelope, duration = read_envelope(path)
+        flaps = flap_times(syllables(voiced_segments(envelope), envelope), args.offset, duration)
+        flap_ticks, break_ticks = quantize(flaps, args.offset, duration, os.path.relpath(path, ROOT))
+        tables.append((folder, file, duration, flap_ticks, break_ticks))
+
+    with open(args.output, "w", newline="\n") as out:
+        out.write("#pragma once\n\n")
+        out.write("// Generated by tools/flapTables.py from the WAV files in resources. Do not edit, run the tool\n")
+        out.write("// again when the sounds change. Durations in FLAP_TICK_MS, the first flap starts %d ms\n" % args.offset)
+        out.write("// after the sound.\n\n")
+        out.write("#include \"Arduino.h\"\n#include \"BirdFlapGenerator.h\"\n\n")
+        out.write("static_assert(FLAP_TICK_MS == %d, \"FlapTables.h was generated for another tick, run tools/flapTables.py\");\n\n"
+                  % TICK_MS)
+        for folder, file, duration, flap_ticks, break_ticks in tables:
+            out.write("// %02d/%03d.wav, %d ms\n" % (folder, file, duration))
+            out.write(c_array("flaps_%02d_%03d" % (folder, file), flap_ticks))
+            out.write(c_array("breaks_%02d_%03d" % (folder, file), break_ticks))
+            out.write("\n")
+
+        out.write("static const FlapTable flapTables[] PROGMEM = {\n")
+        out.write("  // folder file duration  flaps  breaks  flapCount  breakCount\n")
+        for folder, file, duration, flap_ticks, break_ticks in tables:
+            out.write("  {%d, %d, %d, flaps_%02d_%03d, breaks_%02d_%03d, %d, %d},\n"
+                      % (folder, file, duration, folder, file, folder, file, len(flap_ticks), len(break_ticks)))
+        out.write("};\n")
+
+    print("%d tables written to %s" % (len(tables), os.path.relpath(args.output, ROOT)))
+
+
+if __name__ == "__main__":
+    main()
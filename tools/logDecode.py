@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""Turns the binary log of the firmware (Log.h) back into text.
+
+A record on serial is 10 bytes: 0xA5, event id, millis() (4 bytes), two values (2 bytes each, signed),
+all little endian. The texts of the events come from script/LogEvents.h, so decode with the
+LogEvents.h the firmware was built with. Timeline events (Timeline.h) and bytes that do not form a
+record (e.g. the boot loader, or the output of the loop profiler) are skipped.
+
+Decode a capture, or the serial port directly:
+    python3 tools/logDecode.py log.bin
+    stty -F /dev/ttyUSB0 9600 raw && python3 tools/logDecode.py /dev/ttyUSB0
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+SYNC = 0xA5                # LOG_SYNC in Log.h
+TIMELINE_SYNC = 0xA6       # TIMELINE_SYNC in Timeline.h
+TIMELINE_LENGTH = 9
+RECORD = struct.Struct("<BBIhh")
+EVENT = re.compile(r'^\s*LOG_EVENT\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)', re.M)
+
+
+def read_events(path):
+    with open(path) as f:
+        return [text for _, text in EVENT.findall(f.read())]
+
+
+def format_record(events, event, time, a, b):
+    if event >= len(events):
+        return None
+    values = iter((a, b))
+    text = re.sub(r"%d", lambda m: str(next(values)), events[event], count=2)
+    return "%10.3f  %s" % (time / 1000.0, text)
+
+
+def decode(stream, events, out):
+    buffer = b""
+    while True:
+        chunk = stream.read1(256) if hasattr(stream, "read1") else stream.read(256)
+        if not chunk:
+            break
+        buffer += chunk
+        while len(buffer) >= RECORD.size:
+            if buffer[0] == TIMELINE_SYNC:
+                buffer = buffer[TIMELINE_LENGTH:]
+                continue
+            if buffer[0] != SYNC:
+                buffer = buffer[1:]
+                continue
+            line = format_record(events, *RECORD.unpack_from(buffer)[1:])
+            if line is None:
+                # not a record, the sync byte was part of something else
+                buffer = buffer[1:]
+                continue
+            out.write(line + "\n")
+            out.flush()
+            buffer = buffer[RECORD.size:]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("input", nargs="?", help="capture file or serial device (default: stdin)")
+    parser.add_argument("--events", default=os.path.join(ROOT, "script", "LogEvents.h"),
+                        help="event list the firmware was built with")
+    args = parser.parse_args()
+
+    events = read_events(args.events)
+    if args.input:
+        with open(args.input, "rb", buffering=0) as stream:
+            decode(stream, events, sys.stdout)
+    else:
+        decode(sys.stdin.buffer, events, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+"""Turns the timeline of the firmware (Timeline.h) into a Chrome trace and measures the latencies.
+
+An event on serial is 9 bytes: 0xA6, kind (new trigger << 7 | phase << 5 | track), trigger id,
+micros() (4 bytes), value (2 bytes, signed), little endian. The track names come from
+script/TimelineTracks.h. Log records (Log.h) on the same port are skipped.
+
+The JSON opens in chrome://tracing or https://ui.perfetto.dev, one row per track. For every trigger
+(sensor edge or shake incident) the tool also prints when each track first reacted to it, and the
+median and maximum of these latencies per trigger track:
+    python3 tools/timelineToChrome.py capture.bin -o timeline.json
+
+micros() wraps around every 71 minutes. The times are unwrapped from one event to the next, so a
+capture has to be continuous with less than 35 minutes between two events.
+"""
+
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+SYNC = 0xA6                # TIMELINE_SYNC in Timeline.h
+LOG_SYNC = 0xA5            # LOG_SYNC in Log.h
+LOG_LENGTH = 10
+EVENT = struct.Struct("<BBBIh")
+PHASES = ("B", "E", "i")
+TRACK = re.compile(r'^\s*TIMELINE_TRACK\(\s*(\w+)\s*,\s*"([^"]*)"\s*\)', re.M)
+
+
+def read_tracks(path):
+    with open(path) as f:
+        return [name for _, name in TRACK.findall(f.read())]
+
+
+def read_events(data, tracks):
+    """Yields (kind, trigger, micros, value) of the valid events in data."""
+    i = 0
+    while i + EVENT.size <= len(data):
+        if data[i] == LOG_SYNC and i + LOG_LENGTH <= len(data):
+            i += LOG_LENGTH
+            continue
+        if data[i] != SYNC:
+            i += 1
+            continue
+        event = EVENT.unpack_from(data, i)[1:]
+        kind = event[0]
+        if kind & 0x1F >= len(tracks) or (kind >> 5) & 0x03 >= len(PHASES):
+            i += 1
+            continue
+        yield event
+        i += EVENT.size
+
+
+def event_name(tracks, track, value):
+    name = tracks[track]
+    if name.startswith("DFPlayer"):
+        return "0x%02X %d" % ((value >> 8) & 0xFF, value & 0xFF)
+    if value:
+        return "%s %d" % (name, value)
+    return name
+
+
+def median(values):
+    values = sorted(values)
+    return values[len(values) // 2]
+
+
+def convert(events, tracks):
+    trace = []
+    for track, name in enumerate(tracks):
+        trace.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": track, "args": {"name": name}})
+        trace.append({"name": "thread_sort_index", "ph": "M", "pid": 1, "tid": track, "args": {"sort_index": track}})
+
+    triggers = {}        # unique trigger -> (track, time, {track: first reaction})
+    current = {}         # trigger id on the wire -> unique trigger
+    next_trigger = 1
+    previous = None
+    now = 0
+    for kind, wire_trigger, micros, value in events:
+        if previous is not None:
+            delta = (micros - previous) & 0xFFFFFFFF
+            if delta >= 0x80000000:
+                delta -= 0x100000000        # dated back to a sensor edge
+            now += delta
+        previous = micros
+
+        track = kind & 0x1F
+        phase = PHASES[(kind >> 5) & 0x03]
+        trigger = None
+        if kind & 0x80:
+            trigger = next_trigger
+            next_trigger += 1
+            current[wire_trigger] = trigger
+            triggers[trigger] = (track, now, {})
+        elif wire_trigger:
+            trigger = current.get(wire_trigger)
+
+        if trigger is not None and phase != "E":
+            origin, start, reactions = triggers[trigger]
+            if track != origin and track not in reactions:
+                reactions[track] = now - start
+
+        entry = {"name": event_name(tracks, track, value), "ph": phase, "ts": now, "pid": 1, "tid": track,
+                 "args": {"trigger": trigger, "value": value}}
+        if phase == "i":
+            entry["s"] = "t"
+        trace.append(entry)
+    return trace, triggers
+
+
+def report(triggers, tracks, out):
+    latencies = {}
+    for trigger, (origin, start, reactions) in sorted(triggers.items()):
+        if not reactions:
+            continue
+        steps = ", ".join("%s +%.1f ms" % (tracks[track], delay / 1000.0)
+                          for track, delay in sorted(reactions.items(), key=lambda item: item[1]))
+        out.write("trigger %4d %-16s at %10.3f s: %s\n" % (trigger, tracks[origin], start / 1e6, steps))
+        for track, delay in reactions.items():
+            latencies.setdefault((origin, track), []).append(delay)
+
+    out.write("\n%-16s %-20s %8s %10s %10s\n" % ("trigger", "reaction", "count", "median ms", "max ms"))
+    for (origin, track), delays in sorted(latencies.items()):
+        out.write("%-16s %-20s %8d %10.1f %10.1f\n" % (
+            tracks[origin], tracks[track], len(delays), median(delays) / 1000.0, max(delays) / 1000.0))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("input", nargs="?", help="capture file (default: stdin)")
+    parser.add_argument("-o", "--output", default="timeline.json", help="Chrome trace to write")
+    parser.add_argument("--tracks", default=os.path.join(ROOT, "script", "TimelineTracks.h"),
+                        help="track list the firmware was built with")
+    args = parser.parse_args()
+
+    tracks = read_tracks(args.tracks)
+    if args.input:
+        with open(args.input, "rb") as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    trace, triggers = convert(read_events(data, tracks), tracks)
+    with open(args.output, "w") as f:
+        json.dump({"traceEvents": trace, "displayTimeUnit": "ms"}, f)
+    report(triggers, tracks, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()